@@ -13,4 +13,19 @@ void sandbox_eth_disable_response(int index, bool disable);
 
 void sandbox_eth_skip_timeout(void);
 
+struct udevice;
+
+/*
+ * sandbox_eth_tx_hand_f - called by the sandbox driver for each sent packet
+ *
+ * dev - sandbox ethernet device
+ * packet - pointer to the sent packet
+ * len - length of the packet
+ * returns 0 if OK, -ve on error
+ */
+typedef int sandbox_eth_tx_hand_f(struct udevice *dev, void *packet,
+				  unsigned int len);
+
+void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler);
+
 #endif /* __ETH_H */
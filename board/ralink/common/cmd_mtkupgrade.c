@@ -11,6 +11,7 @@
 #include <cli.h>
 #include <div64.h>
 #include <environment.h>
+#include <malloc.h>
 #include <xyzModem.h>
 #include <asm/reboot.h>
 #include <linux/mtd/mtd.h>
@@ -18,6 +19,7 @@
 #include <jffs2/jffs2.h>
 
 #include "spl_helper.h"
+#include "dual_image.h"
 #include "flash_helper.h"
 
 #define BUF_SIZE 1024
@@ -405,29 +407,18 @@ static int prompt_countdown(const char *prompt, int delay)
 static int do_data_verify(void *flashdev, uint64_t offset, size_t len,
 			  const void *buf)
 {
-	const u8 *ptr = (const u8 *)buf;
-	size_t readlen;
-	u8 data[SZ_4K];
+#ifdef CONFIG_MTK_UPGRADE_VERIFY_CRC
+	u32 crc = 0;
 	int ret;
 
-	while (len) {
-		readlen = sizeof(data);
-		if (readlen > len)
-			readlen = len;
-
-		ret = mtk_board_flash_read(flashdev, offset, readlen, data);
-		if (ret)
-			return ret;
-
-		if (memcmp(data, ptr, readlen))
-			return 1;
-
-		offset += readlen;
-		ptr += readlen;
-		len -= readlen;
-	}
+	ret = mtk_board_flash_crc32(flashdev, offset, len, &crc);
+	if (ret)
+		return ret;
 
-	return 0;
+	return crc != crc32(0, buf, len);
+#else
+	return mtk_board_flash_verify(flashdev, offset, len, buf);
+#endif
 }
 
 static int do_write_bootloader(void *flash, size_t stock_stage2_off,
@@ -674,26 +665,24 @@ do_write_bl_single:
 	return do_write_bootloader(flash, 0, data_addr, data_size, 0, adv);
 }
 
-static int _write_firmware(void *flash, size_t data_addr, uint32_t data_size,
-			   int no_prompt)
+static int get_firmware_part(void *flash, uint64_t *part_off,
+			     uint64_t *part_size)
 {
-	uint32_t erase_size;
-	uint64_t part_off, part_size, tmp;
-	int ret;
+	uint64_t tmp;
 
-	if (get_mtd_part_info("firmware", &part_off, &part_size)) {
+	if (get_mtd_part_info("firmware", part_off, part_size)) {
 		printf(COLOR_ERROR "*** MTD partition 'firmware' does not "
 		       "exist! ***" COLOR_NORMAL "\n");
 		return CMD_RET_FAILURE;
 	}
 
-	if (!part_off) {
+	if (!*part_off) {
 		printf(COLOR_ERROR "*** MTD partition 'firmware' is not "
 		       "valid! ***" COLOR_NORMAL "\n");
 		return CMD_RET_FAILURE;
 	}
 
-	tmp = part_off;
+	tmp = *part_off;
 
 	if (do_div(tmp, mtk_board_get_flash_erase_size(flash))) {
 		printf(COLOR_ERROR "*** MTD partition 'firmware' does not "
@@ -701,6 +690,134 @@ static int _write_firmware(void *flash, size_t data_addr, uint32_t data_size,
 		return CMD_RET_FAILURE;
 	}
 
+	return CMD_RET_SUCCESS;
+}
+
+static void invalidate_backup_firmware(void *flash)
+{
+#ifdef CONFIG_MTK_DUAL_IMAGE_SUPPORT
+	uint64_t part_off, part_size;
+
+	if (!get_mtd_part_info(CONFIG_MTK_DUAL_IMAGE_PARTNAME_BACKUP,
+			      &part_off, &part_size)) {
+		/* Force backup image to be upgraded on next bootup */
+		mtk_board_flash_erase(flash, part_off,
+			mtk_board_get_flash_erase_size(flash));
+	}
+
+	dual_image_bump_generation();
+#endif
+}
+
+#if defined(CONFIG_MTK_UPGRADE_SKIP_BLANK_PAGES) || \
+    defined(CONFIG_MTK_UPGRADE_SKIP_BLANK_ERASE)
+static bool is_blank(const void *buf, size_t len)
+{
+	const u8 *p = buf;
+
+	if (!((uintptr_t)p & 3)) {
+		for (; len >= 4; p += 4, len -= 4) {
+			if (*(const u32 *)p != 0xffffffff)
+				return false;
+		}
+	}
+
+	for (; len; p++, len--) {
+		if (*p != 0xff)
+			return false;
+	}
+
+	return true;
+}
+#endif
+
+/* Erases the firmware area, skipping the blocks which are already blank */
+static int firmware_erase(void *flash, uint64_t offset, uint64_t len)
+{
+#ifdef CONFIG_MTK_UPGRADE_SKIP_BLANK_ERASE
+	size_t erasesize = mtk_board_get_flash_erase_size(flash);
+	const void *data;
+	void *buf;
+	int ret = 0;
+
+	buf = malloc(erasesize);
+	if (!buf)
+		return mtk_board_flash_erase(flash, offset, len);
+
+	while (len) {
+		data = mtk_board_flash_map(flash, offset, erasesize);
+		if (!data) {
+			ret = mtk_board_flash_read(flash, offset, erasesize,
+						   buf);
+			data = buf;
+		}
+
+		if (ret || !is_blank(data, erasesize))
+			ret = mtk_board_flash_erase(flash, offset, erasesize);
+
+		if (ret)
+			break;
+
+		offset += erasesize;
+		len -= erasesize;
+	}
+
+	free(buf);
+
+	return ret;
+#else
+	return mtk_board_flash_erase(flash, offset, len);
+#endif
+}
+
+/* Programs the firmware data, leaving the blank pages erased */
+static int firmware_write(void *flash, uint64_t offset, size_t len,
+			  const void *buf)
+{
+#ifdef CONFIG_MTK_UPGRADE_SKIP_BLANK_PAGES
+	size_t pagesize = mtk_board_get_flash_page_size(flash);
+	size_t pos = 0, start = 0, chunksz;
+	int ret;
+
+	while (pos < len) {
+		chunksz = min(len - pos, pagesize);
+
+		if (is_blank(buf + pos, chunksz)) {
+			/* Program the pages before this blank one */
+			if (pos > start) {
+				ret = mtk_board_flash_write(flash,
+					offset + start, pos - start,
+					buf + start);
+				if (ret)
+					return ret;
+			}
+
+			start = pos + chunksz;
+		}
+
+		pos += chunksz;
+	}
+
+	if (len > start)
+		return mtk_board_flash_write(flash, offset + start,
+					     len - start, buf + start);
+
+	return 0;
+#else
+	return mtk_board_flash_write(flash, offset, len, buf);
+#endif
+}
+
+static int _write_firmware(void *flash, size_t data_addr, uint32_t data_size,
+			   int no_prompt)
+{
+	uint32_t erase_size;
+	uint64_t part_off, part_size;
+	int ret;
+
+	if (get_firmware_part(flash, &part_off, &part_size))
+		return CMD_RET_FAILURE;
+
 	if (part_size < data_size) {
 		printf("\n" COLOR_ERROR "*** Error: new firmware is larger "
 		       "than mtd partition 'firmware' ***" COLOR_NORMAL "\n");
@@ -716,7 +833,7 @@ static int _write_firmware(void *flash, size_t data_addr, uint32_t data_size,
 	printf("Erasing from 0x%llx to 0x%llx, size 0x%x ... ", part_off,
 	       part_off + erase_size - 1, erase_size);
 
-	ret = mtk_board_flash_erase(flash, part_off, erase_size);
+	ret = firmware_erase(flash, part_off, erase_size);
 
 	if (ret) {
 		printf("Fail\n");
@@ -730,8 +847,7 @@ static int _write_firmware(void *flash, size_t data_addr, uint32_t data_size,
 	printf("Writting from 0x%x to 0x%llx, size 0x%x ... ", data_addr,
 	       part_off, data_size);
 
-	ret = mtk_board_flash_write(flash, part_off, data_size,
-				    (void *)data_addr);
+	ret = firmware_write(flash, part_off, data_size, (void *)data_addr);
 
 	if (ret) {
 		printf("Fail\n");
@@ -745,14 +861,7 @@ static int _write_firmware(void *flash, size_t data_addr, uint32_t data_size,
 	printf("\n" COLOR_PROMPT "*** Firmware upgrade completed! ***"
 	       COLOR_NORMAL "\n");
 
-#ifdef CONFIG_MTK_DUAL_IMAGE_SUPPORT
-	if (!get_mtd_part_info(CONFIG_MTK_DUAL_IMAGE_PARTNAME_BACKUP,
-			      &part_off, &part_size)) {
-		/* Force backup image to be upgraded on next bootup */
-		mtk_board_flash_erase(flash, part_off,
-			mtk_board_get_flash_erase_size(flash));
-	}
-#endif
+	invalidate_backup_firmware(flash);
 
 	if (no_prompt)
 		return CMD_RET_SUCCESS;
@@ -775,6 +884,154 @@ int write_firmware_failsafe(size_t data_addr, uint32_t data_size)
 	return _write_firmware(flash, data_addr, data_size, 1);
 }
 
+#ifdef CONFIG_WEBUI_FAILSAFE_STREAMING
+struct firmware_stream {
+	void *flash;
+	uint64_t part_off;
+	uint64_t part_size;
+	uint64_t offset;
+	size_t erase_size;
+	size_t buflen;
+	u8 *buf;
+};
+
+static struct firmware_stream fw_stream;
+
+static int firmware_stream_flush(struct firmware_stream *fs)
+{
+	uint64_t addr = fs->part_off + fs->offset;
+	int ret;
+
+	if (!fs->buflen)
+		return 0;
+
+	if (fs->offset + fs->buflen > fs->part_size) {
+		printf("\n" COLOR_ERROR "*** Error: new firmware is larger "
+		       "than mtd partition 'firmware' ***" COLOR_NORMAL "\n");
+		return -EFBIG;
+	}
+
+	ret = firmware_erase(fs->flash, addr, fs->erase_size);
+	if (ret) {
+		printf(COLOR_ERROR "*** Flash erasure [%llx-%llx] failed! ***"
+		       COLOR_NORMAL "\n", addr, addr + fs->erase_size - 1);
+		return ret;
+	}
+
+	ret = firmware_write(fs->flash, addr, fs->buflen, fs->buf);
+	if (ret) {
+		printf(COLOR_ERROR "*** Flash program [%llx-%llx] failed! ***"
+		       COLOR_NORMAL "\n", addr, addr + fs->buflen - 1);
+		return ret;
+	}
+
+	fs->offset += fs->buflen;
+	fs->buflen = 0;
+
+	return 0;
+}
+
+void write_firmware_failsafe_stream_abort(void)
+{
+	struct firmware_stream *fs = &fw_stream;
+
+	if (!fs->buf)
+		return;
+
+	if (fs->offset)
+		printf(COLOR_ERROR "*** Firmware upgrade aborted, 0x%llx bytes "
+		       "written ***" COLOR_NORMAL "\n", fs->offset);
+
+	free(fs->buf);
+	fs->buf = NULL;
+}
+
+int write_firmware_failsafe_stream_start(void)
+{
+	struct firmware_stream *fs = &fw_stream;
+
+	write_firmware_failsafe_stream_abort();
+
+	fs->flash = mtk_board_get_flash_dev();
+	if (!fs->flash)
+		return CMD_RET_FAILURE;
+
+	if (get_firmware_part(fs->flash, &fs->part_off, &fs->part_size))
+		return CMD_RET_FAILURE;
+
+	fs->erase_size = mtk_board_get_flash_erase_size(fs->flash);
+	fs->offset = 0;
+	fs->buflen = 0;
+
+	fs->buf = malloc(fs->erase_size);
+	if (!fs->buf) {
+		printf(COLOR_ERROR "*** Insufficient memory for firmware "
+		       "writing ***" COLOR_NORMAL "\n");
+		return CMD_RET_FAILURE;
+	}
+
+	printf("\nWriting firmware to 0x%llx while receiving ...\n",
+	       fs->part_off);
+
+	return CMD_RET_SUCCESS;
+}
+
+int write_firmware_failsafe_stream_data(const void *data, size_t size)
+{
+	struct firmware_stream *fs = &fw_stream;
+	const u8 *ptr = data;
+	size_t len;
+
+	if (!fs->buf)
+		return CMD_RET_FAILURE;
+
+	while (size) {
+		len = min(size, fs->erase_size - fs->buflen);
+
+		memcpy(fs->buf + fs->buflen, ptr, len);
+		fs->buflen += len;
+		ptr += len;
+		size -= len;
+
+		if (fs->buflen < fs->erase_size)
+			break;
+
+		if (firmware_stream_flush(fs)) {
+			write_firmware_failsafe_stream_abort();
+			return CMD_RET_FAILURE;
+		}
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
+int write_firmware_failsafe_stream_end(void)
+{
+	struct firmware_stream *fs = &fw_stream;
+
+	if (!fs->buf)
+		return CMD_RET_FAILURE;
+
+	if (firmware_stream_flush(fs)) {
+		write_firmware_failsafe_stream_abort();
+		return CMD_RET_FAILURE;
+	}
+
+	printf("Firmware written to 0x%llx, size 0x%llx\n", fs->part_off,
+	       fs->offset);
+
+	printf("\n" COLOR_PROMPT "*** Firmware upgrade completed! ***"
+	       COLOR_NORMAL "\n");
+
+	invalidate_backup_firmware(fs->flash);
+
+	free(fs->buf);
+	fs->buf = NULL;
+
+	return CMD_RET_SUCCESS;
+}
+#endif
+
 static int write_firmware(void *flash, size_t data_addr, uint32_t data_size)
 {
 	return _write_firmware(flash, data_addr, data_size, 0);
@@ -8,22 +8,44 @@
 #include <common.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <environment.h>
 #include <image.h>
 #include <div64.h>
+#include <u-boot/crc.h>
 #include <linux/sizes.h>
 #include <linux/mtd/mtd.h>
 #include <jffs2/jffs2.h>
 
+#include "dual_image.h"
 #include "flash_helper.h"
 
 #define SQUASHFS_MAGIC		0x73717368
 
+/* Environment variables of the verification cache */
+#define DUAL_IMAGE_GEN_ENV	"dual_image_gen"
+#define DUAL_IMAGE_CACHE_ENV	"dual_image_cache"
+
+/* Size of the image head covered by the signature */
+#define DUAL_IMAGE_SIG_SIZE	SZ_4K
+
 struct squashfs_super_block {
 	__le32 s_magic;
 	__le32 pad0[9];
 	__le64 bytes_used;
 };
 
+/* Main image left verified in memory by the last dual_image_check() */
+static void *verified_image;
+
+static void *get_load_addr(void)
+{
+#if defined(CONFIG_LOADADDR)
+	return (void *)CONFIG_LOADADDR;
+#elif defined(CONFIG_SYS_LOAD_ADDR)
+	return (void *)CONFIG_SYS_LOAD_ADDR;
+#endif
+}
+
 static int verify_legacy_image(void *flash, uint64_t offset, uint64_t maxsize,
 			       void *load_addr, size_t *image_size)
 {
@@ -105,17 +127,10 @@ static int verify_fit_image(void *flash, uint64_t offset, uint64_t maxsize,
 #endif
 
 static int verify_image(void *flash, uint64_t offset, uint64_t maxsize,
-			size_t *image_size)
+			void *load_addr, size_t *image_size)
 {
-	void *load_addr;
 	int ret;
 
-#if defined(CONFIG_LOADADDR)
-	load_addr = (void *)CONFIG_LOADADDR;
-#elif defined(CONFIG_SYS_LOAD_ADDR)
-	load_addr = (void *)CONFIG_SYS_LOAD_ADDR;
-#endif
-
 	ret = mtk_board_flash_read(flash, offset, sizeof(image_header_t),
 				   load_addr);
 	if (ret) {
@@ -222,22 +237,122 @@ static int verify_rootfs(void *flash, uint64_t offset, uint64_t maxsize,
 	return 1;
 }
 
+static int verify_firmware(void *flash, uint64_t offset, uint64_t partsize,
+			   void *load_addr, size_t *image_size,
+			   size_t *padding_bytes, size_t *rootfs_size)
+{
+	int ret;
+
+	ret = verify_image(flash, offset, partsize, load_addr, image_size);
+	if (ret)
+		return ret;
+
+	return verify_rootfs(flash, offset + *image_size,
+			     partsize - *image_size, padding_bytes,
+			     rootfs_size);
+}
+
+#ifdef CONFIG_MTK_DUAL_IMAGE_VERIFY_CACHE
+/*
+ * The signature of an image consists of the write generation, the offset,
+ * and the size and CRC of its head. Any header change, including the
+ * timestamp, gives a different signature.
+ */
+static int get_image_sig(void *flash, uint64_t offset, uint64_t maxsize,
+			 void *buf, char *sig, size_t sigsz)
+{
+	size_t size, len = DUAL_IMAGE_SIG_SIZE;
+
+	if (len > maxsize)
+		len = maxsize;
+
+	if (mtk_board_flash_read(flash, offset, len, buf))
+		return -EIO;
+
+	switch (genimg_get_format(buf)) {
+	case IMAGE_FORMAT_LEGACY:
+		if (!image_check_hcrc(buf))
+			return -EINVAL;
+		size = image_get_image_size(buf);
+		break;
+#if defined(CONFIG_FIT)
+	case IMAGE_FORMAT_FIT:
+		size = fit_get_size(buf);
+		break;
+#endif
+	default:
+		return -EINVAL;
+	}
+
+	if (len > size)
+		len = size;
+
+	snprintf(sig, sigsz, "%lx,%llx,%zx,%08x",
+		 env_get_ulong(DUAL_IMAGE_GEN_ENV, 16, 0), offset, size,
+		 crc32(0, buf, len));
+
+	return 0;
+}
+
+static bool backup_image_unchanged(void *flash, uint64_t offset,
+				   uint64_t maxsize, void *buf)
+{
+	const char *cached = env_get(DUAL_IMAGE_CACHE_ENV);
+	char sig[64];
+
+	if (!cached)
+		return false;
+
+	if (get_image_sig(flash, offset, maxsize, buf, sig, sizeof(sig)))
+		return false;
+
+	return !strcmp(sig, cached);
+}
+
+static void backup_image_verified(void *flash, uint64_t offset,
+				  uint64_t maxsize, void *buf)
+{
+	char sig[64];
+
+	if (get_image_sig(flash, offset, maxsize, buf, sig, sizeof(sig)))
+		return;
+
+	env_set(DUAL_IMAGE_CACHE_ENV, sig);
+	env_save();
+}
+
+void dual_image_bump_generation(void)
+{
+	env_set_hex(DUAL_IMAGE_GEN_ENV,
+		    env_get_ulong(DUAL_IMAGE_GEN_ENV, 16, 0) + 1);
+	env_save();
+}
+#else
+static inline bool backup_image_unchanged(void *flash, uint64_t offset,
+					  uint64_t maxsize, void *buf)
+{
+	return false;
+}
+
+static inline void backup_image_verified(void *flash, uint64_t offset,
+					 uint64_t maxsize, void *buf)
+{
+}
+
+void dual_image_bump_generation(void)
+{
+}
+#endif
+
 static int copy_firmware(void *flash, uint64_t src_offset, uint64_t dst_offset,
-			 uint64_t size, bool deadc0de)
+			 uint64_t size, bool deadc0de, uint8_t *buff)
 {
 	size_t sizeleft = size, chunksz, erasesize;
+	uint32_t blocks = 0, rewritten = 0;
 	uint64_t addr = dst_offset;
-	uint8_t *buff, *verify;
 	int ret;
 
-#if defined(CONFIG_LOADADDR)
-	buff = (uint8_t *)CONFIG_LOADADDR;
-#elif defined(CONFIG_SYS_LOAD_ADDR)
-	buff = (uint8_t *)CONFIG_SYS_LOAD_ADDR;
-#endif
-
 	erasesize = mtk_board_get_flash_erase_size(flash);
-	verify = buff + erasesize;
 
 	while (sizeleft) {
 		if (sizeleft > erasesize)
@@ -254,6 +369,19 @@ static int copy_firmware(void *flash, uint64_t src_offset, uint64_t dst_offset,
 			return -EIO;
 		}
 
+		blocks++;
+
+		/*
+		 * Leave the block untouched if it already holds the data, with
+		 * the rest of the block erased as it would be after rewriting
+		 */
+		memset(buff + chunksz, 0xff, erasesize - chunksz);
+
+		if (!mtk_board_flash_verify(flash, addr, erasesize, buff))
+			goto next_block;
+
+		rewritten++;
+
 		ret = mtk_board_flash_erase(flash, addr, erasesize);
 		if (ret) {
 			printf("Fatal: failed to erase dst image area\n");
@@ -266,8 +394,8 @@ static int copy_firmware(void *flash, uint64_t src_offset, uint64_t dst_offset,
 			return -EIO;
 		}
 
-		ret = mtk_board_flash_read(flash, addr, chunksz, verify);
-		if (ret) {
+		ret = mtk_board_flash_verify(flash, addr, chunksz, buff);
+		if (ret < 0) {
 			if (ret == -EBADMSG)
 				printf("Dest image data has uncorrectable ECC error\n");
 			else
@@ -275,16 +403,19 @@ static int copy_firmware(void *flash, uint64_t src_offset, uint64_t dst_offset,
 			return -EIO;
 		}
 
-		if (memcmp(buff, verify, chunksz)) {
+		if (ret) {
 			printf("Image data verification failed\n");
 			return 1;
 		}
 
+next_block:
 		src_offset += chunksz;
 		addr += chunksz;
 		sizeleft -= chunksz;
 	}
 
+	printf("%u of %u blocks rewritten\n", rewritten, blocks);
+
 	if (!deadc0de)
 		return 0;
 
@@ -310,14 +441,17 @@ int dual_image_check(void)
 	uint64_t image1_off, image2_off, image1_partsize, image2_partsize;
 	size_t image1_size, image2_size, rootfs1_size = 0, rootfs2_size = 0;
 	size_t image1_padding_bytes = 0, image2_padding_bytes = 0;
-	bool image1_ok, image2_ok;
+	bool image1_ok, image2_ok, image2_unchanged;
 	uint64_t image_total_size;
 	bool deadc0de = false;
-	void *flash;
+	void *flash, *load_addr, *copy_buf;
 	int ret;
 
 	printf("\nStarting dual image checking ...\n");
 
+	verified_image = NULL;
+	load_addr = get_load_addr();
+
 	flash = mtk_board_get_flash_dev();
 	if (!flash) {
 		printf("Fatal: failed to get flash device\n");
@@ -341,36 +475,59 @@ int dual_image_check(void)
 		return -1;
 	}
 
+	/*
+	 * The main image is verified last, so that it is left in memory and
+	 * can be booted without being read from flash again.
+	 */
+	printf("Verifying backup image at 0x%llx...\n", image2_off);
+	image2_unchanged = backup_image_unchanged(flash, image2_off,
+						  image2_partsize, load_addr);
+	if (image2_unchanged) {
+		printf("Unchanged since last verification\n");
+		image2_ok = true;
+	} else {
+		ret = verify_firmware(flash, image2_off, image2_partsize,
+				      load_addr, &image2_size,
+				      &image2_padding_bytes, &rootfs2_size);
+		if (ret < 0) {
+			printf("Dual image checking is bypassed\n");
+			return 0;
+		}
+
+		image2_ok = ret == 0;
+		if (image2_ok)
+			backup_image_verified(flash, image2_off,
+					      image2_partsize, load_addr);
+	}
+
 	printf("Verifying main image at 0x%llx...\n", image1_off);
-	ret = verify_image(flash, image1_off, image1_partsize, &image1_size);
+	ret = verify_firmware(flash, image1_off, image1_partsize, load_addr,
+			      &image1_size, &image1_padding_bytes,
+			      &rootfs1_size);
 	if (ret < 0) {
 		printf("Dual image checking is bypassed\n");
 		return 0;
 	}
 
-	if (ret == 0) {
-		ret = verify_rootfs(flash, image1_off + image1_size,
-				    image1_partsize - image1_size,
-				    &image1_padding_bytes, &rootfs1_size);
-	}
-
 	image1_ok = ret == 0;
 
-	printf("Verifying backup image at 0x%llx...\n", image2_off);
-	ret = verify_image(flash, image2_off, image2_partsize, &image2_size);
-	if (ret < 0) {
-		printf("Dual image checking is bypassed\n");
-		return 0;
-	}
+	if (image1_ok)
+		verified_image = load_addr;
+
+	/* Never restore from a backup image which has not been read fully */
+	if (!image1_ok && image2_unchanged) {
+		printf("Verifying backup image at 0x%llx...\n", image2_off);
+		ret = verify_firmware(flash, image2_off, image2_partsize,
+				      load_addr, &image2_size,
+				      &image2_padding_bytes, &rootfs2_size);
+		if (ret < 0) {
+			printf("Dual image checking is bypassed\n");
+			return 0;
+		}
 
-	if (ret == 0) {
-		ret = verify_rootfs(flash, image2_off + image2_size,
-				    image2_partsize - image2_size,
-				    &image2_padding_bytes, &rootfs2_size);
+		image2_ok = ret == 0;
 	}
 
-	image2_ok = ret == 0;
-
 	if (!image1_ok && !image2_ok) {
 		printf("Fatal: both images are broken.\n");
 		return 3;
@@ -394,9 +551,17 @@ int dual_image_check(void)
 			return 4;
 		}
 
+		/* Copy through the memory after the verified main image */
+		copy_buf = load_addr + ALIGN(image1_size, SZ_4K);
+
 		printf("Restoring backup image ...\n");
 		ret = copy_firmware(flash, image1_off, image2_off,
-			image_total_size, deadc0de);
+			image_total_size, deadc0de, copy_buf);
+
+		/* The whole backup image is now a copy of the main image */
+		if (!ret && deadc0de)
+			backup_image_verified(flash, image2_off,
+					      image2_partsize, copy_buf);
 	} else {
 		image_total_size = image2_size;
 
@@ -412,7 +577,7 @@ int dual_image_check(void)
 
 		printf("Restoring main image ...\n");
 		ret = copy_firmware(flash, image2_off, image1_off,
-			image_total_size, deadc0de);
+			image_total_size, deadc0de, load_addr);
 	}
 
 	if (!ret)
@@ -420,3 +585,8 @@ int dual_image_check(void)
 
 	return ret;
 }
+
+void *dual_image_get_verified_image(void)
+{
+	return verified_image;
+}
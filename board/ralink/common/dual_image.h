@@ -12,4 +12,16 @@
 
 int dual_image_check(void);
 
+/*
+ * Returns the address of the main image if the last dual_image_check() left
+ * it verified in memory, or NULL if it has to be read from flash.
+ */
+void *dual_image_get_verified_image(void);
+
+/*
+ * Invalidates the cached verification of the backup image. To be called
+ * after the firmware has been written.
+ */
+void dual_image_bump_generation(void);
+
 #endif /* _BOARD_RALINK_DUAL_IMAGE_H_ */
@@ -14,10 +14,29 @@ int get_mtd_part_info(const char *partname, uint64_t *off, uint64_t *size);
 
 void *mtk_board_get_flash_dev(void);
 size_t mtk_board_get_flash_erase_size(void *flashdev);
+size_t mtk_board_get_flash_page_size(void *flashdev);
 int mtk_board_flash_erase(void *flashdev, uint64_t offset, uint64_t len);
 int mtk_board_flash_read(void *flashdev, uint64_t offset, size_t len,
 			 void *buf);
 int mtk_board_flash_write(void *flashdev, uint64_t offset, size_t len,
 			  const void *buf);
 
+/*
+ * Returns the address for reading a flash range directly, or NULL if the
+ * range is not memory-mapped. The content is valid until the next erase or
+ * write of the flash. @flashdev may be NULL for memory-mapped flash.
+ */
+const void *mtk_board_flash_map(void *flashdev, uint64_t offset, size_t len);
+
+/*
+ * Reads back a flash range and compares it with @buf. Returns 0 if they
+ * match, 1 if they differ, or a negative error code of the read.
+ */
+int mtk_board_flash_verify(void *flashdev, uint64_t offset, size_t len,
+			   const void *buf);
+
+/* Updates @crc with the CRC32 of a flash range */
+int mtk_board_flash_crc32(void *flashdev, uint64_t offset, size_t len,
+			  u32 *crc);
+
 #endif /* _BOARD_RALINK_FLASH_HELPER_H_ */
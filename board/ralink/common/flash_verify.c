@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Read-back verification of flash data, shared by the upgrade command and
+ * the dual image checking
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <linux/sizes.h>
+#include <u-boot/crc.h>
+
+#include "flash_helper.h"
+
+static bool data_equal(const void *a, const void *b, size_t len)
+{
+	const u32 *wa = a, *wb = b;
+
+	if (!(((uintptr_t)a | (uintptr_t)b) & 3)) {
+		for (; len >= 4; len -= 4) {
+			if (*wa++ != *wb++)
+				return false;
+		}
+	}
+
+	return !memcmp(wa, wb, len);
+}
+
+/*
+ * Reads the flash range one erase block at a time, either comparing it
+ * with @buf, or accumulating its CRC32 into @crc if @buf is NULL.
+ * Memory-mapped flash is used in place.
+ */
+static int flash_verify(void *flashdev, uint64_t offset, size_t len,
+			const void *buf, u32 *crc)
+{
+	size_t chunksz = mtk_board_get_flash_erase_size(flashdev), readlen;
+	const u8 *ptr = buf;
+	u8 fallback[SZ_4K];
+	const void *data;
+	void *rbuf = NULL;
+	int ret = 0;
+
+	while (len) {
+		readlen = min(len, chunksz);
+
+		data = mtk_board_flash_map(flashdev, offset, readlen);
+		if (!data) {
+			if (!rbuf) {
+				rbuf = malloc(chunksz);
+				if (!rbuf) {
+					rbuf = fallback;
+					chunksz = sizeof(fallback);
+					readlen = min(len, chunksz);
+				}
+			}
+
+			ret = mtk_board_flash_read(flashdev, offset, readlen,
+						   rbuf);
+			if (ret)
+				break;
+
+			data = rbuf;
+		}
+
+		if (ptr) {
+			if (!data_equal(data, ptr, readlen)) {
+				ret = 1;
+				break;
+			}
+
+			ptr += readlen;
+		} else {
+			*crc = crc32(*crc, data, readlen);
+		}
+
+		offset += readlen;
+		len -= readlen;
+	}
+
+	if (rbuf != fallback)
+		free(rbuf);
+
+	return ret;
+}
+
+int mtk_board_flash_verify(void *flashdev, uint64_t offset, size_t len,
+			   const void *buf)
+{
+	return flash_verify(flashdev, offset, len, buf, NULL);
+}
+
+int mtk_board_flash_crc32(void *flashdev, uint64_t offset, size_t len,
+			  u32 *crc)
+{
+	return flash_verify(flashdev, offset, len, NULL, crc);
+}
@@ -87,11 +87,15 @@ static int spl_try_load_image(struct spl_image_info *spl_image,
 		*/
 		lzma_len = CONFIG_SYS_BOOTM_LEN;
 
+		bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "lzma");
+
 		ret = lzmaBuffToBuffDecompress((u8 *) spl_image->load_addr,
 			&lzma_len,
 			(u8 *) (image_addr + sizeof(struct image_header)),
 			spl_image->size);
 
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
+
 		if (ret) {
 			printf("Error: LZMA uncompression error: %d\n", ret);
 			return ret;
@@ -100,6 +104,29 @@ static int spl_try_load_image(struct spl_image_info *spl_image,
 		spl_image->size = lzma_len;
 	}
 #endif /* CONFIG_SPL_LZMA */
+#ifdef CONFIG_SPL_LZ4
+	else if (uhdr->ih_comp == IH_COMP_LZ4) {
+		size_t lz4_len = CONFIG_SYS_BOOTM_LEN;
+
+		/*
+		* Uncompress real U-Boot to its defined location in SDRAM
+		*/
+		bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "lz4");
+
+		ret = ulz4fn((void *) (image_addr + sizeof(struct image_header)),
+			spl_image->size, (void *) spl_image->load_addr,
+			&lz4_len);
+
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
+
+		if (ret) {
+			printf("Error: LZ4 uncompression error: %d\n", ret);
+			return ret;
+		}
+
+		spl_image->size = lz4_len;
+	}
+#endif /* CONFIG_SPL_LZ4 */
 	else {
 		debug("Warning: Unsupported compression method found in image "
 		      "header at offset 0x%p\n", image_addr);
@@ -111,6 +138,16 @@ static int spl_try_load_image(struct spl_image_info *spl_image,
 	return 0;
 }
 
+static void *spl_mtk_nor_image_ptr(ulong addr)
+{
+#ifdef CONFIG_MTK_BOARD_FLASH_MMAP
+	/* Cached reads of the flash window are done in bursts */
+	return (void *) CKSEG0ADDR(addr);
+#else
+	return (void *) addr;
+#endif
+}
+
 static int spl_mtk_nor_load_image(struct spl_image_info *spl_image,
 	struct spl_boot_device *bootdev)
 {
@@ -125,7 +162,7 @@ static int spl_mtk_nor_load_image(struct spl_image_info *spl_image,
 	spl_image->flags |= SPL_COPY_PAYLOAD_ONLY;
 
 	/* Try booting without padding */
-	if (!spl_try_load_image(spl_image, (void *) search_start))
+	if (!spl_try_load_image(spl_image, spl_mtk_nor_image_ptr(search_start)))
 		return 0;
 
 	if (!search_sector_size)
@@ -134,7 +171,8 @@ static int spl_mtk_nor_load_image(struct spl_image_info *spl_image,
 	search_start = ALIGN(search_start, search_sector_size);
 
 	while (search_start < search_end) {
-		if (!spl_try_load_image(spl_image, (void *) search_start))
+		if (!spl_try_load_image(spl_image,
+					spl_mtk_nor_image_ptr(search_start)))
 			return 0;
 
 		search_start += search_sector_size;
@@ -150,6 +188,7 @@ SPL_LOAD_IMAGE_METHOD("NOR", 0, BOOT_DEVICE_MTK_NOR, spl_mtk_nor_load_image);
 static int spl_nmbm_init(void)
 {
 	struct mtd_info *lower;
+	ulong start;
 	int ret;
 
 	printf("\n");
@@ -161,9 +200,13 @@ static int spl_nmbm_init(void)
 		return -ENODEV;
 	}
 
+	start = get_timer(0);
+
 	ret = nmbm_attach_mtd(lower, NMBM_F_CREATE, CONFIG_NMBM_MAX_RATIO,
 		CONFIG_NMBM_MAX_BLOCKS, &upper);
 
+	debug("NMBM attached in %lu ms\n", get_timer(start));
+
 	return ret;
 }
 
@@ -179,8 +222,53 @@ void nand_deselect(void)
 }
 #endif
 
-static int spl_mtk_read_nand_image(struct spl_image_info *spl_image,
-				   ulong nand_addr, ulong *data_addr)
+#if defined(CONFIG_SPL_LZMA) && defined(CONFIG_ENABLE_NAND_NMBM)
+static int spl_mtk_nand_lzma_read(void *priv, SizeT offset, void *buf,
+				  SizeT len)
+{
+	ulong data_addr = *(ulong *) priv;
+
+	return nand_spl_load_image(data_addr + offset, len, buf);
+}
+
+/*
+ * Uncompress the image while it is being read from NAND. This avoids reading
+ * the whole compressed image into SDRAM before decoding it.
+ * The logical address space of NMBM is required as the chunks are read at
+ * arbitrary offsets, which is not possible with plain bad block skipping.
+ */
+static int spl_mtk_nand_load_lzma(struct spl_image_info *spl_image,
+				  ulong data_addr)
+{
+	SizeT lzma_len = CONFIG_SYS_BOOTM_LEN;
+	int ret;
+
+	if (!spl_image->entry_point)
+		spl_image->entry_point = spl_image->load_addr;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "lzma");
+
+	ret = lzmaStreamToBuffDecompress((u8 *) spl_image->load_addr,
+		&lzma_len, spl_mtk_nand_lzma_read, &data_addr,
+		spl_image->size);
+
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
+
+	if (ret) {
+		printf("Error: LZMA uncompression error: %d\n", ret);
+		return ret;
+	}
+
+	spl_image->size = lzma_len;
+
+	flush_cache((unsigned long) spl_image->load_addr, spl_image->size);
+
+	return 0;
+}
+#endif
+
+static int spl_mtk_load_nand_image(struct spl_image_info *spl_image,
+				   ulong nand_addr)
 {
 	struct image_header hdr;
 	u32 old_crc;
@@ -206,15 +294,20 @@ static int spl_mtk_read_nand_image(struct spl_image_info *spl_image,
 	if (ret)
 		return -EINVAL;
 
+#if defined(CONFIG_SPL_LZMA) && defined(CONFIG_ENABLE_NAND_NMBM)
+	/* Read the whole image and uncompress it again if streaming fails */
+	if (image_get_comp(&hdr) == IH_COMP_LZMA &&
+	    !spl_mtk_nand_load_lzma(spl_image, nand_addr + sizeof(hdr)))
+		return 0;
+#endif
+
 	dst_addr = (void *) free_dram_bottom();
 
 	if (nand_spl_load_image(nand_addr,
 	    sizeof(hdr) + image_get_data_size(&hdr), dst_addr))
 		return -EINVAL;
 
-	*data_addr = (ulong) dst_addr;
-
-	return 0;
+	return spl_try_load_image(spl_image, dst_addr);
 }
 
 static int spl_mtk_nand_load_image(struct spl_image_info *spl_image,
@@ -223,7 +316,6 @@ static int spl_mtk_nand_load_image(struct spl_image_info *spl_image,
 	ulong search_start = get_mtk_image_search_start();
 	ulong search_end = get_mtk_image_search_end();
 	ulong search_sector_size = get_mtk_image_search_sector_size();
-	ulong image_addr;
 
 #ifdef CONFIG_ENABLE_NAND_NMBM
 	int ret;
@@ -244,10 +336,8 @@ static int spl_mtk_nand_load_image(struct spl_image_info *spl_image,
 	spl_image->flags |= SPL_COPY_PAYLOAD_ONLY;
 
 	/* Try booting without padding */
-	if (!spl_mtk_read_nand_image(spl_image, search_start, &image_addr)) {
-		if (!spl_try_load_image(spl_image, (void *) image_addr))
-			return 0;
-	}
+	if (!spl_mtk_load_nand_image(spl_image, search_start))
+		return 0;
 
 	if (!search_sector_size)
 		return -EINVAL;
@@ -255,12 +345,8 @@ static int spl_mtk_nand_load_image(struct spl_image_info *spl_image,
 	search_start = ALIGN(search_start, search_sector_size);
 
 	while (search_start < search_end) {
-		if (!spl_mtk_read_nand_image(spl_image, search_start,
-					     &image_addr)) {
-			if (!spl_try_load_image(spl_image,
-						(void *) image_addr))
-				return 0;
-		}
+		if (!spl_mtk_load_nand_image(spl_image, search_start))
+			return 0;
 
 		search_start += search_sector_size;
 	}
@@ -18,9 +18,17 @@ static int do_mtkboardboot(cmd_tbl_t *cmdtp, int flag, int argc,
 {
 	char cmd[128];
 	const char *ep;
-
 #ifdef CONFIG_MTK_DUAL_IMAGE_SUPPORT
+	void *image;
+
 	dual_image_check();
+
+	/* Boot the verified main image directly if it is still in memory */
+	image = dual_image_get_verified_image();
+	if (image) {
+		sprintf(cmd, "bootm 0x%08lx", (ulong)image);
+		run_command(cmd, 0);
+	}
 #endif
 
 	ep = env_get("autostart");
@@ -212,6 +212,13 @@ size_t mtk_board_get_flash_erase_size(void *flashdev)
 	return mtd->erasesize;
 }
 
+size_t mtk_board_get_flash_page_size(void *flashdev)
+{
+	struct mtd_info *mtd = (struct mtd_info *)flashdev;
+
+	return mtd->writesize;
+}
+
 int mtk_board_flash_erase(void *flashdev, uint64_t offset, uint64_t len)
 {
 	struct mtd_info *mtd = (struct mtd_info *)flashdev;
@@ -258,4 +265,10 @@ int mtk_board_flash_write(void *flashdev, uint64_t offset, size_t len,
 
 	return mtd_write(mtd, offset, len, &retlen, buf);
 }
+
+const void *mtk_board_flash_map(void *flashdev, uint64_t offset, size_t len)
+{
+	/* NAND is not memory-mapped */
+	return NULL;
+}
 #endif
@@ -19,6 +19,7 @@
 #include <jffs2/jffs2.h>
 
 #include "../common/dual_image.h"
+#include "../common/flash_helper.h"
 
 static struct spi_flash *get_sf_dev(void)
 {
@@ -54,13 +55,22 @@ static int mtkboardboot(void)
 	struct part_info *part;
 	image_header_t hdr;
 	struct spi_flash *sf;
+	const void *data;
 	uint32_t fw_off = CONFIG_DEFAULT_NOR_KERNEL_OFFSET;
 	uint32_t load_addr, size;
 	u8 pnum;
 	int ret;
-
 #ifdef CONFIG_MTK_DUAL_IMAGE_SUPPORT
+	void *image;
+
 	dual_image_check();
+
+	/* Boot the verified main image directly if it is still in memory */
+	image = dual_image_get_verified_image();
+	if (image) {
+		sprintf(cmd, "bootm 0x%08lx", (ulong)image);
+		run_command(cmd, 0);
+	}
 #endif
 
 	ret = mtdparts_init();
@@ -74,8 +84,10 @@ static int mtkboardboot(void)
 		}
 	}
 
-	if (fw_off < SZ_4M - sizeof (hdr)) {
-		memcpy(&hdr, (void *) CONFIG_SPI_ADDR + fw_off, sizeof(hdr));
+	/* Boot in place if the image is in the memory-mapped window */
+	data = mtk_board_flash_map(NULL, fw_off, sizeof(hdr));
+	if (data) {
+		memcpy(&hdr, data, sizeof(hdr));
 
 		switch (genimg_get_format((void *) &hdr)) {
 		case IMAGE_FORMAT_LEGACY:
@@ -87,14 +99,14 @@ static int mtkboardboot(void)
 			break;
 #endif
 		default:
-			printf("Error: no Image found at 0x%08x\n",
-				CONFIG_SPI_ADDR + fw_off);
+			printf("Error: no Image found at 0x%08lx\n",
+				(ulong) data);
 			return CMD_RET_FAILURE;
 		}
 
-		if (size + fw_off <= SZ_4M) {
-			sprintf(cmd, "bootm 0x%08x",
-				CONFIG_SPI_ADDR + fw_off);
+		data = mtk_board_flash_map(NULL, fw_off, size);
+		if (data) {
+			sprintf(cmd, "bootm 0x%08lx", (ulong) data);
 
 			return run_command(cmd, 0);
 		}
@@ -18,6 +18,12 @@
 #include <spi_flash.h>
 #include <dm.h>
 #include <dm/device-internal.h>
+#include <linux/sizes.h>
+
+#include "../common/flash_helper.h"
+
+/* Size of the flash window at CONFIG_SPI_ADDR */
+#define MT7621_FLASH_MMAP_SIZE		SZ_4M
 
 static inline int gpio_output_init(unsigned gpio, int value, const char *label)
 {
@@ -209,6 +215,13 @@ size_t mtk_board_get_flash_erase_size(void *flashdev)
 	return flash->erase_size;
 }
 
+size_t mtk_board_get_flash_page_size(void *flashdev)
+{
+	struct spi_flash *flash = (struct spi_flash *)flashdev;
+
+	return flash->page_size;
+}
+
 int mtk_board_flash_erase(void *flashdev, uint64_t offset, uint64_t len)
 {
 	struct spi_flash *flash = (struct spi_flash *)flashdev;
@@ -216,10 +229,37 @@ int mtk_board_flash_erase(void *flashdev, uint64_t offset, uint64_t len)
 	return spi_flash_erase(flash, offset, len);
 }
 
+const void *mtk_board_flash_map(void *flashdev, uint64_t offset, size_t len)
+{
+#ifdef CONFIG_MTK_BOARD_FLASH_MMAP
+	ulong addr;
+
+	if (offset >= MT7621_FLASH_MMAP_SIZE ||
+	    len > MT7621_FLASH_MMAP_SIZE - offset)
+		return NULL;
+
+	addr = CKSEG0ADDR(CONFIG_SPI_ADDR) + offset;
+
+	/* Drop lines which may be stale after an erase or a write */
+	invalidate_dcache_range(addr, addr + len);
+
+	return (const void *)addr;
+#else
+	return NULL;
+#endif
+}
+
 int mtk_board_flash_read(void *flashdev, uint64_t offset, size_t len,
 			 void *buf)
 {
 	struct spi_flash *flash = (struct spi_flash *)flashdev;
+	const void *data;
+
+	data = mtk_board_flash_map(flashdev, offset, len);
+	if (data) {
+		memcpy(buf, data, len);
+		return 0;
+	}
 
 	return spi_flash_read(flash, offset, len, buf);
 }
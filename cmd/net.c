@@ -10,6 +10,7 @@
 #include <common.h>
 #include <command.h>
 #include <net.h>
+#include <net/tcp.h>
 
 static int netboot_common(enum proto_t, cmd_tbl_t *, int, char * const []);
 
@@ -457,3 +458,43 @@ U_BOOT_CMD(
 );
 
 #endif  /* CONFIG_CMD_LINK_LOCAL */
+
+#if defined(CONFIG_CMD_TCPSTAT)
+static int do_tcpstat(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	struct tcp_stats st;
+
+	if (argc > 1) {
+		if (strcmp(argv[1], "reset"))
+			return CMD_RET_USAGE;
+
+		tcp_reset_stats();
+		return CMD_RET_SUCCESS;
+	}
+
+	tcp_get_stats(&st);
+
+	printf("Segments received:          %u\n", st.segs_in);
+	printf("Segments sent:              %u\n", st.segs_out);
+	printf("Pure ACKs sent:             %u\n", st.acks_out);
+	printf("Delayed ACKs sent:          %u\n", st.delayed_acks);
+	printf("Segments retransmitted:     %u\n", st.rexmits);
+	printf("Fast retransmits:           %u\n", st.fast_rexmits);
+	printf("Retransmission timeouts:    %u\n", st.rexmit_timeouts);
+	printf("Duplicated ACKs received:   %u\n", st.dup_acks_in);
+	printf("Duplicated ACKs sent:       %u\n", st.dup_acks_out);
+	printf("Out-of-order segments:      %u\n", st.ooo_queued);
+	printf("Out-of-order queue hits:    %u\n", st.ooo_hits);
+	printf("Out-of-order segs dropped:  %u\n", st.ooo_drops);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	tcpstat,	2,	1,	do_tcpstat,
+	"show TCP statistics",
+	"- show the TCP counters\n"
+	"tcpstat reset - clear the TCP counters"
+);
+#endif	/* CONFIG_CMD_TCPSTAT */
@@ -7,6 +7,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <div64.h>
 #include <linux/mtd/mtd.h>
 #include <jffs2/load_kernel.h>
 
@@ -93,6 +94,37 @@ static int do_nmbm_rw(int read, struct mtd_info *mtd, uintptr_t addr,
 	return CMD_RET_FAILURE;
 }
 
+static int do_nmbm_bench(struct mtd_info *mtd, uintptr_t addr,
+			 uint64_t offset, size_t size)
+{
+	ulong start, elapsed;
+	uint64_t speed;
+	size_t retlen;
+	int ret;
+
+	printf("Reading from 0x%llx, size 0x%zx ...\n", offset, size);
+
+	start = timer_get_us();
+	ret = mtd_read(mtd, offset, size, &retlen, (void *)addr);
+	elapsed = timer_get_us() - start;
+
+	if (ret) {
+		printf("Failed at 0x%llx\n", offset + retlen);
+		return CMD_RET_FAILURE;
+	}
+
+	if (!elapsed)
+		elapsed = 1;
+
+	/* Bytes per second */
+	speed = lldiv((uint64_t)size * 1000000, elapsed);
+
+	printf("Read 0x%zx bytes in %lu us, %llu.%02llu MB/s\n", size, elapsed,
+	       speed >> 20, ((speed & 0xfffff) * 100) >> 20);
+
+	return CMD_RET_SUCCESS;
+}
+
 static int do_nmbm_mtd_boot(cmd_tbl_t *cmdtp, struct mtd_info *mtd,
 			    int argc, char *const argv[])
 {
@@ -305,6 +337,9 @@ static int do_nmbm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	if (!strcmp(argv[2], "write"))
 		return do_nmbm_rw(0, mtd, addr, offset, (size_t)size);
 
+	if (!strcmp(argv[2], "bench"))
+		return do_nmbm_bench(mtd, addr, offset, (size_t)size);
+
 	return CMD_RET_USAGE;
 }
 
@@ -321,4 +356,5 @@ U_BOOT_CMD(
 	"nmbm <name> erase <offset> <size>        - Erase blocks\n"
 	"nmbm <name> read <addr> <offset> <size>  - Read data\n"
 	"nmbm <name> write <addr> <offset> <size> - Write data\n"
+	"nmbm <name> bench <addr> <offset> <size> - Measure read speed\n"
 );
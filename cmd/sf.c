@@ -541,6 +541,67 @@ static int do_spi_flash_test(int argc, char * const argv[])
 }
 #endif /* CONFIG_CMD_SF_TEST */
 
+#ifdef CONFIG_CMD_SF_BENCH
+static int do_spi_flash_bench(int argc, char * const argv[])
+{
+	unsigned long offset, len, count = 1, i;
+	unsigned long start_us, elapsed_us;
+	uint64_t speed;	/* KiB/s */
+	uint8_t *buf;
+	char *endp;
+	int ret = 0;
+
+	if (argc < 3)
+		return -1;
+	offset = simple_strtoul(argv[1], &endp, 16);
+	if (*argv[1] == 0 || *endp != 0)
+		return -1;
+	len = simple_strtoul(argv[2], &endp, 16);
+	if (*argv[2] == 0 || *endp != 0 || !len)
+		return -1;
+	if (argc > 3) {
+		count = simple_strtoul(argv[3], &endp, 10);
+		if (*argv[3] == 0 || *endp != 0 || !count)
+			return -1;
+	}
+
+	if (offset + len > flash->size) {
+		printf("ERROR: attempting bench past flash size (%#x)\n",
+		       flash->size);
+		return 1;
+	}
+
+	buf = memalign(ARCH_DMA_MINALIGN, len);
+	if (!buf) {
+		printf("Cannot allocate memory (%lu bytes)\n", len);
+		return 1;
+	}
+
+	start_us = timer_get_us();
+	for (i = 0; i < count; i++) {
+		if (spi_flash_read(flash, offset, len, buf)) {
+			printf("Read failed\n");
+			ret = 1;
+			break;
+		}
+	}
+	elapsed_us = max(timer_get_us() - start_us, 1UL);
+
+	free(buf);
+
+	if (ret)
+		return ret;
+
+	speed = (uint64_t)len * count * 1000000;
+	do_div(speed, elapsed_us * 1024);
+
+	printf("SF: %lu x %lu bytes read in %lu us, %llu KiB/s\n", count, len,
+	       elapsed_us, speed);
+
+	return 0;
+}
+#endif /* CONFIG_CMD_SF_BENCH */
+
 static int do_spi_flash(cmd_tbl_t *cmdtp, int flag, int argc,
 			char * const argv[])
 {
@@ -576,6 +637,10 @@ static int do_spi_flash(cmd_tbl_t *cmdtp, int flag, int argc,
 #ifdef CONFIG_CMD_SF_TEST
 	else if (!strcmp(cmd, "test"))
 		ret = do_spi_flash_test(argc, argv);
+#endif
+#ifdef CONFIG_CMD_SF_BENCH
+	else if (!strcmp(cmd, "bench"))
+		ret = do_spi_flash_bench(argc, argv);
 #endif
 	else
 		ret = -1;
@@ -595,6 +660,14 @@ usage:
 #define SF_TEST_HELP
 #endif
 
+#ifdef CONFIG_CMD_SF_BENCH
+#define SF_BENCH_HELP "\nsf bench offset len [count]	" \
+		"- measure the time of reading `len' bytes\n" \
+		"					  at `offset' `count' times"
+#else
+#define SF_BENCH_HELP
+#endif
+
 U_BOOT_CMD(
 	sf,	5,	1,	do_spi_flash,
 	"SPI flash sub-system",
@@ -615,4 +688,5 @@ U_BOOT_CMD(
 	"sf protect lock/unlock sector len	- protect/unprotect 'len' bytes starting\n"
 	"					  at address 'sector'\n"
 	SF_TEST_HELP
+	SF_BENCH_HELP
 );
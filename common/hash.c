@@ -85,6 +85,40 @@ static int hash_finish_sha256(struct hash_algo *algo, void *ctx, void
 }
 #endif
 
+#ifdef CONFIG_MD5
+static int hash_init_md5(struct hash_algo *algo, void **ctxp)
+{
+	struct MD5Context *ctx = malloc(sizeof(struct MD5Context));
+	MD5Init(ctx);
+	*ctxp = ctx;
+	return 0;
+}
+
+static int hash_update_md5(struct hash_algo *algo, void *ctx, const void *buf,
+			   unsigned int size, int is_last)
+{
+	MD5Update((struct MD5Context *)ctx, buf, size);
+	return 0;
+}
+
+static int hash_finish_md5(struct hash_algo *algo, void *ctx, void *dest_buf,
+			   int size)
+{
+	if (size < algo->digest_size)
+		return -1;
+
+	MD5Final(dest_buf, (struct MD5Context *)ctx);
+	free(ctx);
+	return 0;
+}
+
+static void hash_md5_wd(const unsigned char *input, unsigned int ilen,
+			unsigned char *output, unsigned int chunk_sz)
+{
+	md5_wd((unsigned char *)input, ilen, output, chunk_sz);
+}
+#endif
+
 static int hash_init_crc32(struct hash_algo *algo, void **ctxp)
 {
 	uint32_t *ctx = malloc(sizeof(uint32_t));
@@ -158,6 +192,17 @@ static struct hash_algo hash_algo[] = {
 		.hash_finish	= hash_finish_sha256,
 #endif
 	},
+#endif
+#ifdef CONFIG_MD5
+	{
+		.name		= "md5",
+		.digest_size	= 16,
+		.chunk_size	= CHUNKSZ_MD5,
+		.hash_func_ws	= hash_md5_wd,
+		.hash_init	= hash_init_md5,
+		.hash_update	= hash_update_md5,
+		.hash_finish	= hash_finish_md5,
+	},
 #endif
 	{
 		.name		= "crc32",
@@ -226,6 +271,7 @@ int hash_parse_string(const char *algo_name, const char *str, uint8_t *result)
 		char chr[3];
 
 		strncpy(chr, &str[i * 2], 2);
+		chr[2] = '\0';
 		result[i] = simple_strtoul(chr, NULL, 16);
 	}
 
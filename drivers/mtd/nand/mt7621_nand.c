@@ -564,6 +564,61 @@ static void nfc_read_sector_oob(mt7621_nfc_t *nfc, u32 idx, void *out)
 	}
 }
 
+static bool nfc_use_dma(mt7621_nfc_sel_t *nfc_sel, const u8 *buf)
+{
+	return nfc_sel->use_dma && IS_ALIGNED((ulong) buf, ARCH_DMA_MINALIGN);
+}
+
+/*
+ * Transfer the sectors of a page between the NFI and @buf using the AHB
+ * master. NFI_CNFG and NFI_CON must have been set up for the operation.
+ */
+static int nfc_dma_transfer(mt7621_nfc_t *nfc, struct nand_chip *chip,
+			    const u8 *buf, bool write)
+{
+	u32 len = chip->ecc.steps * chip->ecc.size;
+	u32 val;
+	int ret;
+
+	/* Write back the data to be sent, or drop any line to be overwritten */
+	if (write)
+		flush_dcache_range((ulong) buf, (ulong) buf + len);
+	else
+		invalidate_dcache_range((ulong) buf, (ulong) buf + len);
+
+	nfi_write32(nfc, NFI_STRADDR_REG32, CPHYSADDR((u32) buf));
+
+	/* Clear the stale status before starting */
+	nfi_write16(nfc, NFI_INTR_EN_REG16, AHB_DONE);
+	nfi_read16(nfc, NFI_INTR_REG16);
+
+	nfi_write16(nfc, NFI_STRDATA_REG16, STR_DATA);
+
+	ret = readw_poll_timeout(nfc->nfi_base + NFI_INTR_REG16, val,
+		(val & AHB_DONE), NFI_STATUS_WAIT_TIMEOUT_US);
+
+	if (!ret && !write) {
+		/* Wait for the last sector to be written to the memory */
+		ret = readw_poll_timeout(nfc->nfi_base + NFI_BYTELEN_REG16, val,
+			REG_GET_VAL(BUS_SEC_CNTR, val) >= chip->ecc.steps,
+			NFI_STATUS_WAIT_TIMEOUT_US);
+	}
+
+	nfi_write16(nfc, NFI_INTR_EN_REG16, 0);
+
+	if (ret) {
+		printf("Error: NFI master timed out for DMA %s\n",
+		       write ? "write" : "read");
+		return -EIO;
+	}
+
+	/* Lines may have been fetched speculatively during the transfer */
+	if (!write)
+		invalidate_dcache_range((ulong) buf, (ulong) buf + len);
+
+	return 0;
+}
+
 /*
  * @read_page:	function to read a page according to the ECC generator
  *		requirements; returns maximum number of bitflips corrected in
@@ -574,11 +629,13 @@ static int nfc_read_page_hwecc(struct mtd_info *mtd, struct nand_chip *chip,
 {
 	mt7621_nfc_t *nfc = nand_get_controller_data(chip);
 	mt7621_nfc_sel_t *nfc_sel = nand_to_mt7621_chip(chip);
+	bool dma = nfc_use_dma(nfc_sel, buf);
 	int bitflips = 0, ret = 0;
 	int rc, i;
 
 	nfi_setbits16(nfc, NFI_CNFG_REG16,
-		      READ_MODE | AUTO_FMT_EN | HW_ECC_EN);
+		      READ_MODE | AUTO_FMT_EN | HW_ECC_EN |
+		      (dma ? DMA_MODE | DMA_BURST_EN : 0));
 
 	nfc_ecc_init(nfc, &chip->ecc);
 	nfc_ecc_decoder_start(nfc);
@@ -586,8 +643,16 @@ static int nfc_read_page_hwecc(struct mtd_info *mtd, struct nand_chip *chip,
 	nfi_write16(nfc, NFI_CON_REG16,
 		    NFI_BRD | REG_SET_VAL(NFI_SEC, chip->ecc.steps));
 
+	if (dma) {
+		ret = nfc_dma_transfer(nfc, chip, buf, false);
+		if (ret)
+			goto out;
+	}
+
 	for (i = 0; i < chip->ecc.steps; i++) {
-		nfc_read_buf(mtd, page_data_ptr(chip, buf, i), chip->ecc.size);
+		if (!dma)
+			nfc_read_buf(mtd, page_data_ptr(chip, buf, i),
+				     chip->ecc.size);
 
 		rc = nfc_ecc_decoder_wait_done(nfc, i);
 
@@ -610,10 +675,14 @@ static int nfc_read_page_hwecc(struct mtd_info *mtd, struct nand_chip *chip,
 		}
 	}
 
+out:
 	nfc_ecc_decoder_stop(nfc);
 
 	nfi_write16(nfc, NFI_CON_REG16, 0);
 
+	if (dma)
+		nfi_clrbits16(nfc, NFI_CNFG_REG16, DMA_MODE | DMA_BURST_EN);
+
 	if (ret < 0)
 		return ret;
 
@@ -697,6 +766,8 @@ static int nfc_write_page_hwecc(struct mtd_info *mtd, struct nand_chip *chip,
 	const u8 *buf, int oob_on, int page)
 {
 	mt7621_nfc_t *nfc = nand_get_controller_data(chip);
+	mt7621_nfc_sel_t *nfc_sel = nand_to_mt7621_chip(chip);
+	bool dma = nfc_use_dma(nfc_sel, buf);
 	int ret;
 
 	if (nfc_check_empty_page(mtd, chip, buf)) {
@@ -714,7 +785,8 @@ static int nfc_write_page_hwecc(struct mtd_info *mtd, struct nand_chip *chip,
 	}
 
 	nfi_clrsetbits16(nfc, NFI_CNFG_REG16, READ_MODE,
-			 AUTO_FMT_EN | HW_ECC_EN);
+			 AUTO_FMT_EN | HW_ECC_EN |
+			 (dma ? DMA_MODE | DMA_BURST_EN : 0));
 
 	nfc_ecc_init(nfc, &chip->ecc);
 	nfc_ecc_encoder_start(nfc);
@@ -724,14 +796,22 @@ static int nfc_write_page_hwecc(struct mtd_info *mtd, struct nand_chip *chip,
 	nfi_write16(nfc, NFI_CON_REG16,
 		    NFI_BWR | REG_SET_VAL(NFI_SEC, chip->ecc.steps));
 
-	nfc_write_buf(mtd, buf, mtd->writesize);
-
-	ret = nfc_wait_write_completion(nfc, chip);
+	if (dma) {
+		ret = nfc_dma_transfer(nfc, chip, buf, true);
+		if (!ret)
+			ret = nfc_wait_write_completion(nfc, chip);
+	} else {
+		nfc_write_buf(mtd, buf, mtd->writesize);
+		ret = nfc_wait_write_completion(nfc, chip);
+	}
 
 	nfc_ecc_encoder_stop(nfc);
 
 	nfi_write16(nfc, NFI_CON_REG16, 0);
 
+	if (dma)
+		nfi_clrbits16(nfc, NFI_CNFG_REG16, DMA_MODE | DMA_BURST_EN);
+
 	return ret;
 }
 
@@ -1062,6 +1142,7 @@ static void nfc_probe(mt7621_nfc_t *nfc, int cs)
 	mtd_set_ooblayout(&chip->mtd, &nfc_ooblayout_ops);
 
 	nfc_sel->acccon_val = NFI_DEFAULT_ACCESS_TIMING;
+	nfc_sel->use_dma = CONFIG_IS_ENABLED(NAND_MT7621_DMA);
 
 	/* Reset NFI master */
 	nfc_hw_reset(nfc);
@@ -798,6 +798,9 @@ typedef struct mt7621_nfc_sel {
 
 	void *page_cache;
 	void *oob_mb_cache;
+
+	/* Transfer ECC pages with the AHB master of the NFI */
+	bool use_dma;
 } mt7621_nfc_sel_t;
 
 typedef struct mt7621_nfc {
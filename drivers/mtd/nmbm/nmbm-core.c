@@ -657,9 +657,10 @@ static void nmbm_erase_range(struct nmbm_instance *ni, uint32_t ba,
  * @ba: block address where the data will be written to
  * @data: the data to be written
  * @size: size of the data
+ * @pages: number of pages to be written
  *
- * Write data to every page of the block. Success only if all pages within
- * this block have been successfully written.
+ * Write data to the first @pages pages of the block. Success only if all
+ * these pages have been successfully written.
  *
  * Make sure data size is not bigger than one page.
  *
@@ -667,7 +668,8 @@ static void nmbm_erase_range(struct nmbm_instance *ni, uint32_t ba,
  * NMBM_TRY_COUNT times.
  */
 static bool nmbm_write_repeated_data(struct nmbm_instance *ni, uint32_t ba,
-				     const void *data, uint32_t size)
+				     const void *data, uint32_t size,
+				     uint32_t pages)
 {
 	uint64_t addr, off;
 	bool success;
@@ -678,7 +680,8 @@ static bool nmbm_write_repeated_data(struct nmbm_instance *ni, uint32_t ba,
 
 	addr = ba2addr(ni, ba);
 
-	for (off = 0; off < ni->lower.erasesize; off += ni->lower.writesize) {
+	for (off = 0; off < (uint64_t)pages << ni->writesize_shift;
+	     off += ni->lower.writesize) {
 		WATCHDOG_RESET();
 
 		/* Prepare page data. fill 0xff to unused region */
@@ -711,7 +714,8 @@ static bool nmbm_write_repeated_data(struct nmbm_instance *ni, uint32_t ba,
  * @signature_ba: the actual block address where signature is written to
  *
  * Write signature within a specific range, from chip bottom to limit.
- * At most one block will be written.
+ * At most one block will be written. Pages after ni->hint_start_page are
+ * left erased for the info table location hints.
  *
  * @limit is not counted into the allowed write address.
  */
@@ -733,7 +737,8 @@ static bool nmbm_write_signature(struct nmbm_instance *ni, uint32_t limit,
 			goto skip_bad_block;
 
 		success = nmbm_write_repeated_data(ni, ba, signature,
-						   sizeof(*signature));
+						   sizeof(*signature),
+						   ni->hint_start_page);
 		if (success) {
 			*signature_ba = ba;
 			return true;
@@ -920,6 +925,137 @@ static bool nmbm_write_mgmt_range(struct nmbm_instance *ni, uint32_t ba,
 	return true;
 }
 
+/*
+ * nmbm_read_hint_page - Read a page of the hint area
+ * @ni: NMBM instance structure
+ * @page: page index within the signature block
+ * @hint: buffer to store the hint
+ *
+ * Return true if the page has been written, or can't be read.
+ */
+static bool nmbm_read_hint_page(struct nmbm_instance *ni, uint32_t page,
+				struct nmbm_hint *hint)
+{
+	uint64_t addr = ba2addr(ni, ni->signature_ba) +
+			((uint64_t)page << ni->writesize_shift);
+	const uint8_t *p = (const uint8_t *)hint;
+	uint32_t i;
+
+	if (nmbn_read_data(ni, addr, hint, sizeof(*hint)))
+		return true;
+
+	for (i = 0; i < sizeof(*hint); i++) {
+		if (p[i] != 0xff)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * nmbm_read_hint - Read the latest info table location hint
+ * @ni: NMBM instance structure
+ *
+ * Hints are appended to the pages after the signatures in the signature
+ * block, so the latest hint is the one before the first erased page.
+ * A signature block written by older versions has no erased page, and no
+ * hint will be used or written.
+ */
+static void nmbm_read_hint(struct nmbm_instance *ni)
+{
+	uint32_t lo = ni->hint_start_page, hi, mid;
+	struct nmbm_hint hint;
+
+	ni->hint_main_table_ba = 0;
+	ni->hint_backup_table_ba = 0;
+
+	/* Binary search for the first erased page */
+	hi = ni->lower.erasesize >> ni->writesize_shift;
+
+	while (lo < hi) {
+		WATCHDOG_RESET();
+
+		mid = (lo + hi) / 2;
+		if (nmbm_read_hint_page(ni, mid, &hint))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	ni->hint_page = lo;
+
+	if (lo == ni->hint_start_page)
+		return;
+
+	if (!nmbm_read_hint_page(ni, lo - 1, &hint))
+		return;
+
+	if (!nmbm_check_header(&hint, sizeof(hint)) ||
+	    hint.header.magic != NMBM_MAGIC_HINT)
+		return;
+
+	ni->hint_main_table_ba = hint.main_table_ba;
+	ni->hint_backup_table_ba = hint.backup_table_ba;
+
+	nlog_debug(ni, "Info table hint: main %u, backup %u\n",
+		   hint.main_table_ba, hint.backup_table_ba);
+}
+
+/*
+ * nmbm_write_hint - Record the current location of info tables
+ * @ni: NMBM instance structure
+ *
+ * Nothing will be written if the location is not changed, or there is no
+ * erased page left in the signature block. A stale hint is harmless as it
+ * will be validated while loading.
+ */
+static void nmbm_write_hint(struct nmbm_instance *ni)
+{
+	uint64_t addr;
+	struct nmbm_hint hint;
+
+	if (ni->protected || !ni->main_table_ba || !ni->backup_table_ba)
+		return;
+
+	if (ni->main_table_ba == ni->hint_main_table_ba &&
+	    ni->backup_table_ba == ni->hint_backup_table_ba)
+		return;
+
+	if (ni->hint_page >= ni->lower.erasesize >> ni->writesize_shift)
+		return;
+
+	memset(&hint, 0, sizeof(hint));
+	hint.header.magic = NMBM_MAGIC_HINT;
+	hint.header.version = NMBM_VER;
+	hint.header.size = sizeof(hint);
+	hint.main_table_ba = ni->main_table_ba;
+	hint.backup_table_ba = ni->backup_table_ba;
+	nmbm_update_checksum(&hint.header);
+
+	memcpy(ni->page_cache, &hint, sizeof(hint));
+	memset(ni->page_cache + sizeof(hint), 0xff,
+	       ni->rawpage_size - sizeof(hint));
+
+	addr = ba2addr(ni, ni->signature_ba) +
+	       ((uint64_t)ni->hint_page << ni->writesize_shift);
+
+	/*
+	 * A failed page may still read as erased, and writing the pages after
+	 * it would break both the search for the latest hint and the in-order
+	 * programming of the block. Stop writing hints to this block instead.
+	 * Never mark the signature block bad.
+	 */
+	if (!nmbm_write_phys_page(ni, addr, ni->page_cache, NULL,
+				  NMBM_MODE_PLACE_OOB)) {
+		ni->hint_page = ni->lower.erasesize >> ni->writesize_shift;
+		return;
+	}
+
+	ni->hint_page++;
+	ni->hint_main_table_ba = ni->main_table_ba;
+	ni->hint_backup_table_ba = ni->backup_table_ba;
+}
+
 /*
  * nmbm_generate_info_table_cache - Generate info table cache data
  * @ni: NMBM instance structure
@@ -1490,6 +1626,10 @@ static bool nmbm_update_info_table(struct nmbm_instance *ni)
 	if (ni->protected)
 		return true;
 
+	/* Changes are committed at the end of the logical operation */
+	if (ni->update_deferred)
+		return true;
+
 	while (ni->block_state_changed || ni->block_mapping_changed) {
 		success = nmbm_update_info_table_once(ni, false);
 		if (!success) {
@@ -1498,9 +1638,44 @@ static bool nmbm_update_info_table(struct nmbm_instance *ni)
 		}
 	}
 
+	nmbm_write_hint(ni);
+
 	return true;
 }
 
+/*
+ * nmbm_defer_update - Start a logical operation
+ * @ni: NMBM instance structure
+ *
+ * Changes to the state table and mapping table made by the operation are
+ * kept in memory, and are written to the info tables only once by
+ * nmbm_commit_update() when the operation finishes.
+ */
+static void nmbm_defer_update(struct nmbm_instance *ni)
+{
+	ni->update_deferred++;
+}
+
+/*
+ * nmbm_commit_update - Finish a logical operation
+ * @ni: NMBM instance structure
+ *
+ * Write pending changes to the info tables. Return false if the info
+ * tables could not be updated.
+ *
+ * A power cut before the commit leaves the old info tables on the chip,
+ * which is safe: the old physical block of a remapped logic block has
+ * already been marked bad or will fail again and be remapped, and the new
+ * spare block is still free according to the old tables.
+ */
+static bool nmbm_commit_update(struct nmbm_instance *ni)
+{
+	if (--ni->update_deferred)
+		return true;
+
+	return nmbm_update_info_table(ni);
+}
+
 /*
  * nmbm_map_block - Map a bad block to a unused spare block
  * @ni: NMBM instance structure
@@ -1625,6 +1800,11 @@ static bool nmbm_create_new(struct nmbm_instance *ni)
 
 	nlog_info(ni, "Signature has been written to block %u [0x%08llx]\n",
 		 ni->signature_ba, ba2addr(ni, ni->signature_ba));
+
+	/* The hint area of a new signature block is empty */
+	ni->hint_page = ni->hint_start_page;
+	ni->hint_main_table_ba = 0;
+	ni->hint_backup_table_ba = 0;
 	nmbm_mark_block_color_signature(ni, ni->signature_ba);
 
 	/* Write info table(s) */
@@ -1718,7 +1898,7 @@ static bool nmbm_try_load_info_table(struct nmbm_instance *ni, uint32_t ba,
 	struct nmbm_info_table_header *ifthdr = (void *)ni->info_table_cache;
 	uint8_t *off = ni->info_table_cache;
 	uint32_t limit = ba + size2blk(ni, ni->info_table_size);
-	uint32_t start_ba = 0, chunksize, sizeremain = ni->info_table_size;
+	uint32_t start_ba = 0, chunksize, hdrsize, sizeremain = ni->info_table_size;
 	bool success, checkhdr = true;
 	int ret;
 
@@ -1737,18 +1917,36 @@ static bool nmbm_try_load_info_table(struct nmbm_instance *ni, uint32_t ba,
 		if (chunksize > ni->lower.erasesize)
 			chunksize = ni->lower.erasesize;
 
+		hdrsize = 0;
+
+		if (checkhdr) {
+			/*
+			 * The header occupies the first page. Check it before
+			 * reading the rest of the block
+			 */
+			hdrsize = ni->lower.writesize;
+
+			ret = nmbn_read_data(ni, ba2addr(ni, ba), off,
+					     hdrsize);
+			if (ret < 0)
+				goto skip_bad_block;
+			else if (ret > 0)
+				return false;
+
+			success = nmbm_check_info_table_header(ni, off);
+			if (!success)
+				return false;
+		}
+
 		/* Assume block with ECC error has no info table data */
-		ret = nmbn_read_data(ni, ba2addr(ni, ba), off, chunksize);
+		ret = nmbn_read_data(ni, ba2addr(ni, ba) + hdrsize,
+				     off + hdrsize, chunksize - hdrsize);
 		if (ret < 0)
 			goto skip_bad_block;
 		else if (ret > 0)
 			return false;
 
 		if (checkhdr) {
-			success = nmbm_check_info_table_header(ni, off);
-			if (!success)
-				return false;
-
 			start_ba = ba;
 			checkhdr = false;
 		}
@@ -1833,6 +2031,58 @@ static bool nmbm_search_info_table(struct nmbm_instance *ni, uint32_t ba,
 	return false;
 }
 
+/*
+ * nmbm_load_hinted_info_table - Load info tables from the hinted location
+ * @ni: NMBM instance structure
+ * @ba: start block address to search info table
+ * @limit: highest block address allowed for searching
+ * @main_table_end_ba: return the block address after end of main table
+ * @main_write_count: return the write count of main table
+ * @main_mapping_blocks_top_ba: return the top remapped block of main table
+ * @backup_table_end_ba: return the block address after end of backup table
+ * @backup_write_count: return the write count of backup table
+ * @backup_mapping_blocks_top_ba: return the top remapped block of backup table
+ *
+ * Both tables must be valid and have the same write count. Otherwise the
+ * hint is treated as stale, and the info tables will be searched.
+ */
+static bool nmbm_load_hinted_info_table(struct nmbm_instance *ni, uint32_t ba,
+					uint32_t limit,
+					uint32_t *main_table_end_ba,
+					uint32_t *main_write_count,
+					uint32_t *main_mapping_blocks_top_ba,
+					uint32_t *backup_table_end_ba,
+					uint32_t *backup_write_count,
+					uint32_t *backup_mapping_blocks_top_ba)
+{
+	uint32_t main_ba = ni->hint_main_table_ba;
+	uint32_t backup_ba = ni->hint_backup_table_ba;
+	bool success;
+
+	if (main_ba < ba || backup_ba <= main_ba || backup_ba >= limit)
+		return false;
+
+	success = nmbm_try_load_info_table(ni, main_ba, main_table_end_ba,
+					   main_write_count,
+					   main_mapping_blocks_top_ba, false);
+	if (!success || *main_table_end_ba > backup_ba)
+		return false;
+
+	success = nmbm_try_load_info_table(ni, backup_ba, backup_table_end_ba,
+					   backup_write_count,
+					   backup_mapping_blocks_top_ba, true);
+	if (!success || *backup_table_end_ba > limit)
+		return false;
+
+	if (*main_write_count != *backup_write_count)
+		return false;
+
+	ni->main_table_ba = main_ba;
+	ni->backup_table_ba = backup_ba;
+
+	return true;
+}
+
 /*
  * nmbm_load_info_table - Load info table(s) from a chip
  * @ni: NMBM instance structure
@@ -1855,6 +2105,25 @@ static bool nmbm_load_info_table(struct nmbm_instance *ni, uint32_t ba,
 	ni->mapping_blocks_top_ba = ni->signature_ba - 1;
 	ni->data_block_count = ni->signature.mgmt_start_pb;
 
+	/* Try the location recorded by the hint first */
+	success = nmbm_load_hinted_info_table(ni, ba, limit,
+		&main_table_end_ba, &main_table_write_count,
+		&main_mapping_blocks_top_ba, &backup_table_end_ba,
+		&backup_table_write_count, &backup_mapping_blocks_top_ba);
+	if (success) {
+		table_end_ba = backup_table_end_ba;
+
+		nlog_table_found(ni, true, main_table_write_count,
+				ni->main_table_ba, main_table_end_ba);
+		nlog_table_found(ni, false, backup_table_write_count,
+				ni->backup_table_ba, backup_table_end_ba);
+
+		goto tables_found;
+	}
+
+	/* The hinted tables may have been partially loaded */
+	ni->info_table.write_count = 0;
+
 	/* Find first info table */
 	success = nmbm_search_info_table(ni, ba, limit, &ni->main_table_ba,
 		&main_table_end_ba, &main_table_write_count,
@@ -1882,6 +2151,7 @@ static bool nmbm_load_info_table(struct nmbm_instance *ni, uint32_t ba,
 				ni->backup_table_ba, backup_table_end_ba);
 	}
 
+tables_found:
 	/* Pick mapping_blocks_top_ba */
 	if (!ni->backup_table_ba) {
 		ni->mapping_blocks_top_ba= main_mapping_blocks_top_ba;
@@ -1934,6 +2204,9 @@ static bool nmbm_load_info_table(struct nmbm_instance *ni, uint32_t ba,
 		success = true;
 	}
 
+	if (success)
+		nmbm_write_hint(ni);
+
 	/*
 	 * If there is no spare unmapped blocks, or still only one table
 	 * exists, set the chip to read-only
@@ -2170,6 +2443,9 @@ static void nmbm_init_structure(struct nmbm_instance *ni)
 	ni->writesize_shift = ffs(ni->lower.writesize) - 1;
 	ni->erasesize_shift = ffs(ni->lower.erasesize) - 1;
 
+	/* Signatures occupy the first half of the signature block */
+	ni->hint_start_page = pages_per_block - pages_per_block / 2;
+
 	/* Calculate number of block this chip */
 	ni->block_count = ni->lower.size >> ni->erasesize_shift;
 
@@ -2271,6 +2547,8 @@ int nmbm_attach(struct nmbm_lower_device *nld, struct nmbm_instance *ni)
 		return -EINVAL;
 	}
 
+	nmbm_read_hint(ni);
+
 	success = nmbm_load_existing(ni);
 	if (!success)
 		return -ENODEV;
@@ -2362,7 +2640,7 @@ int nmbm_erase_block_range(struct nmbm_instance *ni, uint64_t addr,
 			   uint64_t size, uint64_t *failed_addr)
 {
 	uint32_t start_ba, end_ba;
-	int ret;
+	int ret = 0;
 
 	if (!ni)
 		return -EINVAL;
@@ -2391,6 +2669,8 @@ int nmbm_erase_block_range(struct nmbm_instance *ni, uint64_t addr,
 	start_ba = addr2ba(ni, addr);
 	end_ba = addr2ba(ni, addr + size - 1);
 
+	nmbm_defer_update(ni);
+
 	while (start_ba <= end_ba) {
 		WATCHDOG_RESET();
 
@@ -2398,13 +2678,16 @@ int nmbm_erase_block_range(struct nmbm_instance *ni, uint64_t addr,
 		if (ret) {
 			if (failed_addr)
 				*failed_addr = ba2addr(ni, start_ba);
-			return ret;
+			break;
 		}
 
 		start_ba++;
 	}
 
-	return 0;
+	if (!nmbm_commit_update(ni) && !ret)
+		ret = -EIO;
+
+	return ret;
 }
 
 /*
@@ -2488,6 +2771,61 @@ int nmbm_read_single_page(struct nmbm_instance *ni, uint64_t addr, void *data,
 	return nmbm_read_logic_page(ni, addr, data, oob, mode);
 }
 
+/*
+ * nmbm_read_logic_pages - Read consecutive pages of one logic block
+ * @ni: NMBM instance structure
+ * @addr: logic linear address, must be page aligned
+ * @data: buffer to store main data
+ * @size: data size to read, multiple of page size, must not cross the
+ *        boundary of the logic block
+ * @mode: read mode
+ * @retlen: return actual data size read
+ *
+ * The block mapping is resolved only once, and all pages are read by one
+ * call to the lower device if possible. On any failure, the pages are read
+ * one by one again to locate the failed page.
+ */
+static int nmbm_read_logic_pages(struct nmbm_instance *ni, uint64_t addr,
+				 void *data, size_t size,
+				 enum nmbm_oob_mode mode, size_t *retlen)
+{
+	uint32_t lb, pb, offset;
+	uint8_t *ptr = data;
+	size_t sizeremain;
+	int ret;
+
+	*retlen = 0;
+
+	if (ni->lower.read_pages) {
+		lb = addr2ba(ni, addr);
+		offset = addr & ni->erasesize_mask;
+		pb = ni->block_mapping[lb];
+
+		if ((int32_t)pb >= 0 &&
+		    nmbm_get_block_state(ni, pb) != BLOCK_ST_BAD) {
+			ret = ni->lower.read_pages(ni->lower.arg,
+						   ba2addr(ni, pb) + offset,
+						   data, size, mode);
+			if (!ret) {
+				*retlen = size;
+				return 0;
+			}
+		}
+	}
+
+	for (sizeremain = size; sizeremain; sizeremain -= ni->lower.writesize) {
+		ret = nmbm_read_logic_page(ni, addr, ptr, NULL, mode);
+		if (ret)
+			return ret;
+
+		addr += ni->lower.writesize;
+		ptr += ni->lower.writesize;
+		*retlen += ni->lower.writesize;
+	}
+
+	return 0;
+}
+
 /*
  * nmbm_read_range - Read data without oob
  * @ni: NMBM instance structure
@@ -2502,7 +2840,7 @@ int nmbm_read_range(struct nmbm_instance *ni, uint64_t addr, size_t size,
 {
 	uint64_t off = addr;
 	uint8_t *ptr = data;
-	size_t sizeremain = size, chunksize, leading;
+	size_t sizeremain = size, chunksize, leading, readlen;
 	int ret;
 
 	if (!ni)
@@ -2529,6 +2867,8 @@ int nmbm_read_range(struct nmbm_instance *ni, uint64_t addr, size_t size,
 		return 0;
 	}
 
+	nmbm_defer_update(ni);
+
 	while (sizeremain) {
 		WATCHDOG_RESET();
 
@@ -2538,10 +2878,19 @@ int nmbm_read_range(struct nmbm_instance *ni, uint64_t addr, size_t size,
 			chunksize = sizeremain;
 
 		if (chunksize == ni->lower.writesize) {
-			ret = nmbm_read_logic_page(ni, off - leading, ptr,
-							NULL, mode);
-			if (ret)
+			/* Read whole pages till the end of this block */
+			chunksize = ni->lower.erasesize -
+				    (off & ni->erasesize_mask);
+			if (chunksize > sizeremain)
+				chunksize = sizeremain &
+					    ~(size_t)ni->writesize_mask;
+
+			ret = nmbm_read_logic_pages(ni, off, ptr, chunksize,
+						    mode, &readlen);
+			if (ret) {
+				sizeremain -= readlen;
 				break;
+			}
 		} else {
 			ret = nmbm_read_logic_page(ni, off - leading,
 							ni->page_cache, NULL,
@@ -2557,6 +2906,9 @@ int nmbm_read_range(struct nmbm_instance *ni, uint64_t addr, size_t size,
 		sizeremain -= chunksize;
 	}
 
+	/* Blocks failed to be read are remapped on next erasing */
+	nmbm_commit_update(ni);
+
 	if (retlen)
 		*retlen = size - sizeremain;
 
@@ -2684,6 +3036,8 @@ int nmbm_write_range(struct nmbm_instance *ni, uint64_t addr, size_t size,
 		return 0;
 	}
 
+	nmbm_defer_update(ni);
+
 	while (sizeremain) {
 		WATCHDOG_RESET();
 
@@ -2713,6 +3067,9 @@ int nmbm_write_range(struct nmbm_instance *ni, uint64_t addr, size_t size,
 		sizeremain -= chunksize;
 	}
 
+	if (!nmbm_commit_update(ni) && !ret)
+		ret = -EIO;
+
 	if (retlen)
 		*retlen = size - sizeremain;
 
@@ -2783,6 +3140,21 @@ int nmbm_mark_bad_block(struct nmbm_instance *ni, uint64_t addr)
 	return 0;
 }
 
+/*
+ * nmbm_sync - Write pending changes to the info tables
+ * @ni: NMBM instance structure
+ */
+int nmbm_sync(struct nmbm_instance *ni)
+{
+	if (!ni)
+		return -EINVAL;
+
+	if (!nmbm_update_info_table(ni))
+		return -EIO;
+
+	return 0;
+}
+
 /*
  * nmbm_get_avail_size - Get available user data size
  * @ni: NMBM instance structure
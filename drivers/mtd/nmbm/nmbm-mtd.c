@@ -89,6 +89,47 @@ static int nmbm_lower_read_page(void *arg, uint64_t addr, void *buf, void *oob,
 	return 0;
 }
 
+static int nmbm_lower_read_pages(void *arg, uint64_t addr, void *buf,
+				 size_t size, enum nmbm_oob_mode mode)
+{
+	struct nmbm_mtd *nm = arg;
+	struct mtd_oob_ops ops;
+	int ret;
+
+	memset(&ops, 0, sizeof(ops));
+
+	switch (mode) {
+	case NMBM_MODE_PLACE_OOB:
+		ops.mode = MTD_OPS_PLACE_OOB;
+		break;
+	case NMBM_MODE_AUTO_OOB:
+		ops.mode = MTD_OPS_AUTO_OOB;
+		break;
+	case NMBM_MODE_RAW:
+		ops.mode = MTD_OPS_RAW;
+		break;
+	default:
+		pr_debug("%s: unsupported NMBM mode: %u\n", __func__, mode);
+		return -ENOTSUPP;
+	}
+
+	/* Let the NAND driver read all pages in one go */
+	ops.datbuf = buf;
+	ops.len = size;
+
+	ret = mtd_read_oob(nm->lower, addr, &ops);
+	nm->upper.ecc_stats.corrected = nm->lower->ecc_stats.corrected;
+	nm->upper.ecc_stats.failed = nm->lower->ecc_stats.failed;
+
+	if (ret == -EBADMSG)
+		return 1;
+
+	if (ret && ret != -EUCLEAN)
+		return ret;
+
+	return 0;
+}
+
 static int nmbm_lower_write_page(void *arg, uint64_t addr, const void *buf,
 				 const void *oob, enum nmbm_oob_mode mode)
 {
@@ -490,6 +531,13 @@ static int nmbm_mtd_block_markbad(struct mtd_info *mtd, loff_t offs)
 	return nmbm_mark_bad_block(nm->ni, offs);
 }
 
+static void nmbm_mtd_sync(struct mtd_info *mtd)
+{
+	struct nmbm_mtd *nm = container_of(mtd, struct nmbm_mtd, upper);
+
+	nmbm_sync(nm->ni);
+}
+
 int nmbm_attach_mtd(struct mtd_info *lower, int flags, uint32_t max_ratio,
 		    uint32_t max_reserved_blocks, struct mtd_info **upper)
 {
@@ -534,6 +582,7 @@ int nmbm_attach_mtd(struct mtd_info *lower, int flags, uint32_t max_ratio,
 	nld.arg = nm;
 	nld.reset_chip = nmbm_lower_reset_chip;
 	nld.read_page = nmbm_lower_read_page;
+	nld.read_pages = nmbm_lower_read_pages;
 	nld.write_page = nmbm_lower_write_page;
 	nld.erase_block = nmbm_lower_erase_block;
 	nld.is_bad_block = nmbm_lower_is_bad_block;
@@ -595,6 +644,7 @@ int nmbm_attach_mtd(struct mtd_info *lower, int flags, uint32_t max_ratio,
 	mtd->_write_oob = nmbm_mtd_write_oob;
 	mtd->_block_isbad = nmbm_mtd_block_isbad;
 	mtd->_block_markbad = nmbm_mtd_block_markbad;
+	mtd->_sync = nmbm_mtd_sync;
 
 	*upper = mtd;
 
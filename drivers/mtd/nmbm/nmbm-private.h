@@ -14,6 +14,7 @@
 
 #define NMBM_MAGIC_SIGNATURE			0x304d4d4e	/* NMM0 */
 #define NMBM_MAGIC_INFO_TABLE			0x314d4d4e	/* NMM1 */
+#define NMBM_MAGIC_HINT				0x324d4d4e	/* NMM2 */
 
 #define NMBM_VERSION_MAJOR_S			0
 #define NMBM_VERSION_MAJOR_M			0xffff
@@ -66,6 +67,12 @@ struct nmbm_signature {
 	uint8_t padding[3];
 };
 
+struct nmbm_hint {
+	struct nmbm_header header;
+	uint32_t main_table_ba;
+	uint32_t backup_table_ba;
+};
+
 struct nmbm_info_table_header {
 	struct nmbm_header header;
 	uint32_t write_count;
@@ -105,6 +112,9 @@ struct nmbm_instance {
 
 	int protected;
 
+	/* Nesting level of logical operations deferring info table updates */
+	uint32_t update_deferred;
+
 	uint32_t block_count;
 	uint32_t data_block_count;
 
@@ -115,6 +125,12 @@ struct nmbm_instance {
 	uint32_t mapping_blocks_top_ba;
 	uint32_t signature_ba;
 
+	/* Info table location hint stored in the signature block */
+	uint32_t hint_start_page;
+	uint32_t hint_page;
+	uint32_t hint_main_table_ba;
+	uint32_t hint_backup_table_ba;
+
 	enum nmbm_log_category log_display_level;
 };
 
@@ -38,6 +38,18 @@ static int spi_flash_read_write(struct spi_slave *spi,
 int spi_flash_cmd_read(struct spi_slave *spi, const u8 *cmd,
 		size_t cmd_len, void *data, size_t data_len)
 {
+	int ret;
+
+	if (data_len) {
+		ret = spi_read_flash(spi, cmd, cmd_len, data, data_len);
+		if (ret != -ENOSYS) {
+			if (ret)
+				debug("SF: Failed to read %zu bytes of data: %d\n",
+				      data_len, ret);
+			return ret;
+		}
+	}
+
 	return spi_flash_read_write(spi, cmd, cmd_len, NULL, data, data_len);
 }
 
@@ -22,12 +22,21 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
-#define NUM_TX_DESC		24
-#define NUM_RX_DESC		24
+#define NUM_TX_DESC		CONFIG_MT7621_ETH_TX_DESC_NUM
+#define NUM_RX_DESC		CONFIG_MT7621_ETH_RX_DESC_NUM
+#ifdef CONFIG_MT7621_ETH_TX_ZERO_COPY
+#define TX_TOTAL_BUF_SIZE	0
+#else
 #define TX_TOTAL_BUF_SIZE	(NUM_TX_DESC * PKTSIZE_ALIGN)
+#endif
 #define RX_TOTAL_BUF_SIZE	(NUM_RX_DESC * PKTSIZE_ALIGN)
 #define TOTAL_PKT_BUF_SIZE	(TX_TOTAL_BUF_SIZE + RX_TOTAL_BUF_SIZE)
 
+/* Number of freed RX descriptors to be returned to DMA at once */
+#define RX_RECYCLE_BATCH	(NUM_RX_DESC / 4)
+
+#define TX_DMA_TIMEOUT		100
+
 #define MT7530_NUM_PHYS		5
 
 #define GDMA_FWD_TO_CPU \
@@ -133,6 +142,7 @@ struct mt7621_eth_priv {
 	PDMA_rxdesc *rx_ring_noc;
 
 	int rx_dma_owner_idx0;
+	int rx_recycle_num;
 	int tx_cpu_owner_idx0;
 
 	void __iomem *fe_base;
@@ -532,6 +542,7 @@ static void mt7621_eth_fifo_init(struct mt7621_eth_priv *priv)
 	priv->tx_ring_noc = (PDMA_txdesc *) UNCACHED_SDRAM(&priv->tx_ring);
 	priv->rx_ring_noc = (PDMA_rxdesc *) UNCACHED_SDRAM(&priv->rx_ring);
 	priv->rx_dma_owner_idx0 = 0;
+	priv->rx_recycle_num = 0;
 	priv->tx_cpu_owner_idx0 = 0;
 
 	for (i = 0; i < NUM_TX_DESC; i++) {
@@ -539,8 +550,10 @@ static void mt7621_eth_fifo_init(struct mt7621_eth_priv *priv)
 		priv->tx_ring_noc[i].txd_info2.DDONE = 1;
 		priv->tx_ring_noc[i].txd_info4.FPORT = DP_GDMA1;
 
+#ifndef CONFIG_MT7621_ETH_TX_ZERO_COPY
 		priv->tx_ring_noc[i].txd_info1.SDP0 = virt_to_phys(pkt_base);
 		pkt_base += PKTSIZE_ALIGN;
+#endif
 	}
 
 	for (i = 0; i < NUM_RX_DESC; i++) {
@@ -609,38 +622,78 @@ static int mt7621_eth_write_hwaddr(struct udevice *dev)
 	return 0;
 }
 
+#ifdef CONFIG_MT7621_ETH_TX_ZERO_COPY
+static int mt7621_eth_tx_wait(struct mt7621_eth_priv *priv, int idx)
+{
+	volatile PDMA_txdesc *txd = &priv->tx_ring_noc[idx];
+	ulong start = get_timer(0);
+
+	while (!txd->txd_info2.DDONE) {
+		if (get_timer(start) > TX_DMA_TIMEOUT) {
+			printf("mt7621-eth: TX DMA timed out\n");
+			return -ETIMEDOUT;
+		}
+	}
+
+	return 0;
+}
+#endif
+
 static int mt7621_eth_send(struct udevice *dev, void *packet, int length)
 {
 	struct mt7621_eth_priv *priv = dev_get_priv(dev);
+	int idx = priv->tx_cpu_owner_idx0;
 	void *pkt_base;
 
-	if (!priv->tx_ring_noc[priv->tx_cpu_owner_idx0].txd_info2.DDONE) {
+	if (!priv->tx_ring_noc[idx].txd_info2.DDONE) {
 		printf("mt7621-eth: TX DMA descriptor ring is full\n");
 		return -EPERM;
 	}
 
-	pkt_base = (void *) phys_to_virt(
-		priv->tx_ring_noc[priv->tx_cpu_owner_idx0].txd_info1.SDP0);
+#ifdef CONFIG_MT7621_ETH_TX_ZERO_COPY
+	pkt_base = packet;
+	priv->tx_ring_noc[idx].txd_info1.SDP0 = virt_to_phys(pkt_base);
+#else
+	pkt_base = (void *) phys_to_virt(priv->tx_ring_noc[idx].txd_info1.SDP0);
 	memcpy(pkt_base, packet, length);
+#endif
 	flush_dcache_range((u32) pkt_base, (u32) pkt_base + length);
 
-	priv->tx_ring_noc[priv->tx_cpu_owner_idx0].txd_info2.SDL0 = length;
+	priv->tx_ring_noc[idx].txd_info2.SDL0 = length;
 
-	priv->tx_ring_noc[priv->tx_cpu_owner_idx0].txd_info2.DDONE = 0;
+	priv->tx_ring_noc[idx].txd_info2.DDONE = 0;
 
-	priv->tx_cpu_owner_idx0 = (priv->tx_cpu_owner_idx0 + 1) % NUM_TX_DESC;
+	priv->tx_cpu_owner_idx0 = (idx + 1) % NUM_TX_DESC;
 	mt7621_pdma_write(priv, TX_CTX_IDX_REG(0), priv->tx_cpu_owner_idx0);
 
+#ifdef CONFIG_MT7621_ETH_TX_ZERO_COPY
+	/* The packet buffer can be reused once it has been fetched by DMA */
+	return mt7621_eth_tx_wait(priv, idx);
+#else
 	return 0;
+#endif
 }
 
-static int mt7621_eth_recv(struct udevice *dev, int flags, uchar **packetp)
+static void mt7621_eth_rx_recycle(struct mt7621_eth_priv *priv)
+{
+	if (!priv->rx_recycle_num)
+		return;
+
+	/* Return all freed descriptors to DMA by a single register write */
+	mt7621_pdma_write(priv, RX_CRX_IDX_REG(0),
+		(priv->rx_dma_owner_idx0 + NUM_RX_DESC - 1) % NUM_RX_DESC);
+	priv->rx_recycle_num = 0;
+}
+
+static int mt7621_eth_rx_fetch(struct mt7621_eth_priv *priv, uchar **packetp)
 {
-	struct mt7621_eth_priv *priv = dev_get_priv(dev);
 	uchar *pkt_base;
 	u32 length;
 
 	if (!priv->rx_ring_noc[priv->rx_dma_owner_idx0].rxd_info2.DDONE) {
+		/* End of a burst, give the freed descriptors back to DMA */
+		mt7621_eth_rx_recycle(priv);
+
 		debug("mt7621-eth: RX DMA descriptor ring is empty\n");
 		return -EAGAIN;
 	}
@@ -656,21 +709,60 @@ static int mt7621_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 	return length;
 }
 
-static int mt7621_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
+static void mt7621_eth_rx_release(struct mt7621_eth_priv *priv)
 {
-	struct mt7621_eth_priv *priv = dev_get_priv(dev);
-
 	priv->rx_ring_noc[priv->rx_dma_owner_idx0].rxd_info2.DDONE = 0;
 	priv->rx_ring_noc[priv->rx_dma_owner_idx0].rxd_info2.LS0 = 0;
 	priv->rx_ring_noc[priv->rx_dma_owner_idx0].rxd_info2.PLEN0 =
 		PKTSIZE_ALIGN;
 
-	mt7621_pdma_write(priv, RX_CRX_IDX_REG(0), priv->rx_dma_owner_idx0);
 	priv->rx_dma_owner_idx0 = (priv->rx_dma_owner_idx0 + 1) % NUM_RX_DESC;
 
+	/* Keep DMA supplied with descriptors during long bursts */
+	if (++priv->rx_recycle_num >= RX_RECYCLE_BATCH)
+		mt7621_eth_rx_recycle(priv);
+}
+
+static int mt7621_eth_recv(struct udevice *dev, int flags, uchar **packetp)
+{
+	struct mt7621_eth_priv *priv = dev_get_priv(dev);
+
+	return mt7621_eth_rx_fetch(priv, packetp);
+}
+
+static int mt7621_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
+{
+	struct mt7621_eth_priv *priv = dev_get_priv(dev);
+
+	mt7621_eth_rx_release(priv);
+
 	return 0;
 }
 
+static int mt7621_eth_recv_burst(struct udevice *dev, int flags, int budget)
+{
+	struct mt7621_eth_priv *priv = dev_get_priv(dev);
+	uchar *packet;
+	int length, num = 0;
+
+	/* Drain all completed descriptors without going through the uclass */
+	while (num < budget) {
+		length = mt7621_eth_rx_fetch(priv, &packet);
+		if (length < 0)
+			break;
+
+		if (length > 0)
+			net_process_received_packet(packet, length);
+
+		mt7621_eth_rx_release(priv);
+		num++;
+	}
+
+	mt7621_eth_rx_recycle(priv);
+
+	return num;
+}
+
 static int mt7621_eth_probe(struct udevice *dev)
 {
 	struct mt7621_eth_priv *priv = dev_get_priv(dev);
@@ -760,6 +852,7 @@ static const struct eth_ops mt7621_eth_ops = {
 	.send = mt7621_eth_send,
 	.recv = mt7621_eth_recv,
 	.free_pkt = mt7621_eth_free_pkt,
+	.recv_burst = mt7621_eth_recv_burst,
 	.write_hwaddr = mt7621_eth_write_hwaddr,
 };
 
@@ -10,6 +10,7 @@
 #include <errno.h>
 #include <spi.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 #include <linux/bitops.h>
 #include <linux/iopoll.h>
 
@@ -53,6 +54,7 @@
 struct mt7621_spi_priv {
 	void __iomem *base;
 	u32 bus_freq;
+	u32 morebuf;
 };
 
 static u32 mt7621_spi_get_clk_div(u32 hclk_freq, u32 freq)
@@ -100,80 +102,153 @@ static void mt7621_spi_set_cs(struct mt7621_spi_priv *priv, int cs, int enable)
 	}
 }
 
+static int mt7621_spi_start(struct mt7621_spi_priv *priv, u32 morebuf)
+{
+	/* The bit counts are the same for most chunks of a transfer */
+	if (morebuf != priv->morebuf) {
+		writel(morebuf, priv->base + SPI_MOREBUF_REG);
+		priv->morebuf = morebuf;
+	}
+
+	writel(SPI_MASTER_START, priv->base + SPI_TRANS_REG);
+
+	return mt7621_spi_busy_wait(priv);
+}
+
+/*
+ * Load at most MT7621_TX_FIFO_LEN bytes to be sent into the opcode and DIDO
+ * registers. Returns the bit counts to be set in SPI_MOREBUF_REG.
+ */
+static u32 mt7621_spi_fill_tx(struct mt7621_spi_priv *priv, const u8 *buf,
+			      size_t tx_len)
+{
+	size_t opcode_len, dido_len;
+	u32 val;
+	int i;
+
+	opcode_len = min_t(size_t, tx_len, 4);
+	dido_len = tx_len - opcode_len;
+
+	val = 0;
+	for (i = 0; i < opcode_len; i++) {
+		val <<= 8;
+		val |= *buf++;
+	}
+
+	writel(val, priv->base + SPI_OP_ADDR_REG);
+
+	val = 0;
+	for (i = 0; i < dido_len; i++) {
+		val |= (*buf++) << ((i % 4) * 8);
+
+		if ((i % 4 == 3) || (i == dido_len - 1)) {
+			writel(val, priv->base + SPI_DIDO_REG(i / 4));
+			val = 0;
+		}
+	}
+
+	return ((opcode_len * 8) << CMD_BIT_CNT_SHIFT) |
+		((dido_len * 8) << MOSI_BIT_CNT_SHIFT);
+}
+
+/* Unload the data received, the first byte is in the lowest bits of DIDO0 */
+static void mt7621_spi_read_fifo(struct mt7621_spi_priv *priv, u8 *buf,
+				 size_t len)
+{
+	size_t i;
+	u32 val;
+
+	for (i = 0; i + 4 <= len; i += 4)
+		put_unaligned_le32(readl(priv->base + SPI_DIDO_REG(i / 4)),
+				   buf + i);
+
+	if (i == len)
+		return;
+
+	val = readl(priv->base + SPI_DIDO_REG(i / 4));
+	for (; i < len; i++) {
+		buf[i] = val & 0xff;
+		val >>= 8;
+	}
+}
+
 static int mt7621_spi_read(struct mt7621_spi_priv *priv, u8 *buf, size_t len)
 {
 	size_t rx_len;
-	int i, ret;
-	u32 val = 0;
+	int ret;
 
 	while (len) {
 		rx_len = min_t(size_t, len, MT7621_RX_FIFO_LEN);
 
-		writel((rx_len * 8) << MISO_BIT_CNT_SHIFT,
-			priv->base + SPI_MOREBUF_REG);
-		writel(SPI_MASTER_START, priv->base + SPI_TRANS_REG);
-
-		ret = mt7621_spi_busy_wait(priv);
+		ret = mt7621_spi_start(priv, (rx_len * 8) << MISO_BIT_CNT_SHIFT);
 		if (ret)
 			return ret;
 
-		for (i = 0; i < rx_len; i++) {
-			if ((i % 4) == 0)
-				val = readl(priv->base + SPI_DIDO_REG(i / 4));
-			*buf++ = val & 0xff;
-			val >>= 8;
-		}
+		mt7621_spi_read_fifo(priv, buf, rx_len);
 
+		buf += rx_len;
 		len -= rx_len;
 	}
 
-	return ret;
+	return 0;
 }
 
 static int mt7621_spi_write(struct mt7621_spi_priv *priv, const u8 *buf,
 			    size_t len)
 {
-	size_t tx_len, opcode_len, dido_len;
-	int i, ret;
-	u32 val;
+	size_t tx_len;
+	u32 morebuf;
+	int ret;
 
 	while (len) {
 		tx_len = min_t(size_t, len, MT7621_TX_FIFO_LEN);
 
-		opcode_len = min_t(size_t, tx_len, 4);
-		dido_len = tx_len - opcode_len;
+		morebuf = mt7621_spi_fill_tx(priv, buf, tx_len);
 
-		val = 0;
-		for (i = 0; i < opcode_len; i++) {
-			val <<= 8;
-			val |= *buf++;
-		}
+		ret = mt7621_spi_start(priv, morebuf);
+		if (ret)
+			return ret;
 
-		writel(val, priv->base + SPI_OP_ADDR_REG);
+		buf += tx_len;
+		len -= tx_len;
+	}
 
-		val = 0;
-		for (i = 0; i < dido_len; i++) {
-			val |= (*buf++) << ((i % 4) * 8);
+	return 0;
+}
 
-			if ((i % 4 == 3) || (i == dido_len - 1)) {
-				writel(val, priv->base + SPI_DIDO_REG(i / 4));
-				val = 0;
-			}
-		}
+static int mt7621_spi_read_flash(struct udevice *dev, const u8 *cmd,
+				 size_t cmd_len, void *data, size_t data_len)
+{
+	struct udevice *bus = dev_get_parent(dev);
+	struct mt7621_spi_priv *priv = dev_get_priv(bus);
+	struct dm_spi_slave_platdata *plat = dev_get_parent_platdata(dev);
+	size_t rx_len;
+	u32 morebuf;
+	int ret;
 
-		writel(((opcode_len * 8) << CMD_BIT_CNT_SHIFT) |
-			((dido_len * 8) << MOSI_BIT_CNT_SHIFT),
-			priv->base + SPI_MOREBUF_REG);
-		writel(SPI_MASTER_START, priv->base + SPI_TRANS_REG);
+	if (cmd_len > MT7621_TX_FIFO_LEN)
+		return -ENOSYS;
 
-		ret = mt7621_spi_busy_wait(priv);
-		if (ret)
-			return ret;
+	mt7621_spi_set_cs(priv, plat->cs, 1);
 
-		len -= tx_len;
+	/*
+	 * The first chunk of data is received by the transaction sending the
+	 * command, instead of using a separated one.
+	 */
+	rx_len = min_t(size_t, data_len, MT7621_RX_FIFO_LEN);
+
+	morebuf = mt7621_spi_fill_tx(priv, cmd, cmd_len);
+	morebuf |= (rx_len * 8) << MISO_BIT_CNT_SHIFT;
+
+	ret = mt7621_spi_start(priv, morebuf);
+	if (!ret) {
+		mt7621_spi_read_fifo(priv, data, rx_len);
+		ret = mt7621_spi_read(priv, data + rx_len, data_len - rx_len);
 	}
 
-	return 0;
+	mt7621_spi_set_cs(priv, plat->cs, 0);
+
+	return ret;
 }
 
 static int mt7621_spi_xfer(struct udevice *dev, unsigned int bitlen,
@@ -280,12 +355,14 @@ static int mt7621_spi_probe(struct udevice *bus)
 
 	priv->base = (void __iomem *) devfdt_get_addr(bus);
 	priv->bus_freq = get_bus_freq(0);
+	priv->morebuf = readl(priv->base + SPI_MOREBUF_REG);
 
 	return 0;
 }
 
 static const struct dm_spi_ops mt7621_spi_ops = {
 	.xfer       = mt7621_spi_xfer,
+	.read_flash = mt7621_spi_read_flash,
 	.set_speed  = mt7621_spi_set_speed,
 	.set_mode   = mt7621_spi_set_mode,
 };
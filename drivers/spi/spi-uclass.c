@@ -90,6 +90,22 @@ int dm_spi_xfer(struct udevice *dev, unsigned int bitlen,
 	return spi_get_ops(bus)->xfer(dev, bitlen, dout, din, flags);
 }
 
+int spi_read_flash(struct spi_slave *slave, const u8 *cmd, size_t cmd_len,
+		   void *data, size_t data_len)
+{
+	struct udevice *bus = slave->dev->parent;
+	struct dm_spi_ops *ops;
+
+	if (bus->uclass->uc_drv->id != UCLASS_SPI)
+		return -ENOSYS;
+
+	ops = spi_get_ops(bus);
+	if (!ops->read_flash)
+		return -ENOSYS;
+
+	return ops->read_flash(slave->dev, cmd, cmd_len, data, data_len);
+}
+
 int spi_claim_bus(struct spi_slave *slave)
 {
 	return dm_spi_claim_bus(slave->dev);
@@ -136,6 +152,8 @@ static int spi_post_probe(struct udevice *bus)
 		ops->set_wordlen += gd->reloc_off;
 	if (ops->xfer)
 		ops->xfer += gd->reloc_off;
+	if (ops->read_flash)
+		ops->read_flash += gd->reloc_off;
 	if (ops->set_speed)
 		ops->set_speed += gd->reloc_off;
 	if (ops->set_mode)
@@ -10,7 +10,6 @@
 #include <malloc.h>
 #include <net/tcp.h>
 #include <net/httpd.h>
-#include <u-boot/md5.h>
 
 #include "fs.h"
 
@@ -21,6 +20,15 @@ static int upgrade_success;
 
 extern int write_firmware_failsafe(size_t data_addr, uint32_t data_size);
 
+#ifdef CONFIG_WEBUI_FAILSAFE_STREAMING
+extern int write_firmware_failsafe_stream_start(void);
+extern int write_firmware_failsafe_stream_data(const void *data, size_t size);
+extern int write_firmware_failsafe_stream_end(void);
+extern void write_firmware_failsafe_stream_abort(void);
+
+static int upload_stream_ret = -1;
+#endif
+
 static int output_plain_file(struct httpd_response *response,
 	const char *filename)
 {
@@ -55,12 +63,39 @@ static void index_handler(enum httpd_uri_handler_status status,
 		output_plain_file(response, "index.html");
 }
 
+#ifdef CONFIG_WEBUI_FAILSAFE_STREAMING
+static int upload_stream_handler(enum httpd_upload_status status,
+	struct httpd_request *request,
+	struct httpd_form_value *value,
+	const void *data, size_t size)
+{
+	/* ignore files other than firmware */
+	if (!value->name || strcmp(value->name, "firmware"))
+		return 1;
+
+	switch (status) {
+	case HTTP_UPLOAD_START:
+		upload_stream_ret = -1;
+		return write_firmware_failsafe_stream_start();
+	case HTTP_UPLOAD_DATA:
+		return write_firmware_failsafe_stream_data(data, size);
+	case HTTP_UPLOAD_END:
+		upload_stream_ret = write_firmware_failsafe_stream_end();
+		break;
+	case HTTP_UPLOAD_ABORT:
+		write_firmware_failsafe_stream_abort();
+		break;
+	}
+
+	return 0;
+}
+#endif
+
 static void upload_handler(enum httpd_uri_handler_status status,
 	struct httpd_request *request,
 	struct httpd_response *response)
 {
 	char *buff, *md5_ptr, *size_ptr, size_str[16];
-	u8 md5_sum[16];
 	struct httpd_form_value *fw;
 	const struct fs_desc *file;
 	int i;
@@ -78,6 +113,14 @@ static void upload_handler(enum httpd_uri_handler_status status,
 
 		/* TODO: add firmware validation here if necessary */
 
+#ifdef CONFIG_WEBUI_FAILSAFE_STREAMING
+		if (upload_stream_ret) {
+			/* firmware has not been written completely */
+			output_plain_file(response, "fail.html");
+			return;
+		}
+#endif
+
 		if (output_plain_file(response, "upload.html")) {
 			response->info.code = 500;
 			return;
@@ -92,13 +135,13 @@ static void upload_handler(enum httpd_uri_handler_status status,
 			size_ptr = strstr(buff, "YYYYYYYYYY");
 
 			if (md5_ptr) {
-				md5((u8 *) fw->data, fw->size, md5_sum);
+				/* computed by httpd while receiving */
 				for (i = 0; i < 16; i++) {
 					u8 hex;
 					
-					hex = (md5_sum[i] >> 4) & 0xf;
+					hex = (fw->md5[i] >> 4) & 0xf;
 					md5_ptr[i * 2] = hexchars[hex];
-					hex = md5_sum[i] & 0xf;
+					hex = fw->md5[i] & 0xf;
 					md5_ptr[i * 2 + 1] = hexchars[hex];
 				}
 			}
@@ -190,9 +233,15 @@ static void result_handler(enum httpd_uri_handler_status status,
 			return;
 		}
 
-		if (upload_data_id == upload_id)
+		if (upload_data_id == upload_id) {
+#ifdef CONFIG_WEBUI_FAILSAFE_STREAMING
+			/* firmware has been written while uploading */
+			st->ret = upload_stream_ret;
+#else
 			st->ret = write_firmware_failsafe((size_t) upload_data,
 				upload_size);
+#endif
+		}
 
 		/* invalidate upload identifier */
 		upload_data_id = rand();
@@ -267,7 +316,12 @@ int start_web_failsafe(void)
 
 	httpd_register_uri_handler(inst, "/", &index_handler, NULL);
 	httpd_register_uri_handler(inst, "/cgi-bin/luci", &index_handler, NULL);
+#ifdef CONFIG_WEBUI_FAILSAFE_STREAMING
+	httpd_register_uri_upload_handler(inst, "/upload", &upload_handler,
+					  &upload_stream_handler, NULL);
+#else
 	httpd_register_uri_handler(inst, "/upload", &upload_handler, NULL);
+#endif
 	httpd_register_uri_handler(inst, "/flashing", &flashing_handler, NULL);
 	httpd_register_uri_handler(inst, "/result", &result_handler, NULL);
 	httpd_register_uri_handler(inst, "/style.css", &style_handler, NULL);
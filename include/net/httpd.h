@@ -10,6 +10,7 @@
 #define __NET_HTTPD_H__
 
 #include <linux/list.h>
+#include <u-boot/sha256.h>
 
 #define MAX_HTTP_FORM_VALUE_ITEMS	5
 
@@ -18,6 +19,12 @@ struct httpd_form_value {
 	const char *data;
 	const char *filename;
 	size_t size;
+
+	/* Digests of file data, computed while it is being received */
+	u8 md5[16];
+#ifdef CONFIG_HTTPD_UPLOAD_SHA256
+	u8 sha256[SHA256_SUM_LEN];
+#endif
 };
 
 struct httpd_form_values {
@@ -74,9 +81,27 @@ typedef void(*httpd_uri_handler_cb)(enum httpd_uri_handler_status status,
 				    struct httpd_request *request,
 				    struct httpd_response *response);
 
+enum httpd_upload_status {
+	HTTP_UPLOAD_START,
+	HTTP_UPLOAD_DATA,
+	HTTP_UPLOAD_END,
+	HTTP_UPLOAD_ABORT
+};
+
+/*
+ * Called for file parts of a multipart/form-data request while the request
+ * body is still being received. Returning non-zero stops further callbacks
+ * for the current part.
+ */
+typedef int(*httpd_upload_cb)(enum httpd_upload_status status,
+			      struct httpd_request *request,
+			      struct httpd_form_value *value,
+			      const void *data, size_t size);
+
 struct httpd_uri_handler {
 	const char *uri;
 	httpd_uri_handler_cb cb;
+	httpd_upload_cb upload_cb;
 };
 
 /* Last valid upload identifier */
@@ -100,6 +125,17 @@ int httpd_register_uri_handler(struct httpd_instance *httpd_inst,
 			       httpd_uri_handler_cb cb,
 			       struct httpd_uri_handler **returih);
 
+/*
+ * Register URI handler to a http server instance. Uploaded files are passed
+ * to upload_cb in chunks instead of being buffered in memory. The digests
+ * of a file are valid when HTTP_UPLOAD_END is reported.
+ */
+int httpd_register_uri_upload_handler(struct httpd_instance *httpd_inst,
+				      const char *uri,
+				      httpd_uri_handler_cb cb,
+				      httpd_upload_cb upload_cb,
+				      struct httpd_uri_handler **returih);
+
 /* Unregister URI handler from a http server instance */
 int httpd_unregister_uri_handler(struct httpd_instance *httpd_inst,
 				 struct httpd_uri_handler *urih);
@@ -33,6 +33,21 @@ struct tcb_cb_data {
 
 typedef void (*tcp_conn_cb)(struct tcb_cb_data *cbd);
 
+struct tcp_stats {
+	uint32_t segs_in;
+	uint32_t segs_out;
+	uint32_t acks_out;
+	uint32_t delayed_acks;
+	uint32_t rexmits;
+	uint32_t fast_rexmits;
+	uint32_t rexmit_timeouts;
+	uint32_t dup_acks_in;
+	uint32_t dup_acks_out;
+	uint32_t ooo_queued;
+	uint32_t ooo_hits;
+	uint32_t ooo_drops;
+};
+
 /* Initialize TCP subsystem */
 void tcp_start(void);
 
@@ -63,4 +78,10 @@ void tcp_reset_all_conn(void);
 /* Return 1 if connection is in ESTABLISHED state */
 int tcp_conn_is_alive(const void *conn);
 
+/* Get a copy of the global TCP counters */
+void tcp_get_stats(struct tcp_stats *stats);
+
+/* Clear the global TCP counters */
+void tcp_reset_stats(void);
+
 #endif /* __NET_TCP_H__ */
@@ -51,6 +51,14 @@ struct nmbm_lower_device {
 	 *    return negative number for other errors
 	 */
 	int (*read_page)(void *arg, uint64_t addr, void *buf, void *oob, enum nmbm_oob_mode mode);
+
+	/*
+	 * read_pages: (optional)
+	 *    read main data of consecutive pages within one block
+	 *    return values are the same as read_page
+	 */
+	int (*read_pages)(void *arg, uint64_t addr, void *buf, size_t size, enum nmbm_oob_mode mode);
+
 	int (*write_page)(void *arg, uint64_t addr, const void *buf, const void *oob, enum nmbm_oob_mode mode);
 	int (*erase_block)(void *arg, uint64_t addr);
 
@@ -89,6 +97,8 @@ int nmbm_write_range(struct nmbm_instance *ni, uint64_t addr, size_t size,
 int nmbm_check_bad_block(struct nmbm_instance *ni, uint64_t addr);
 int nmbm_mark_bad_block(struct nmbm_instance *ni, uint64_t addr);
 
+int nmbm_sync(struct nmbm_instance *ni);
+
 uint64_t nmbm_get_avail_size(struct nmbm_instance *ni);
 
 int nmbm_get_lower_device(struct nmbm_instance *ni, struct nmbm_lower_device *nld);
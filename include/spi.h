@@ -253,6 +253,35 @@ int spi_set_wordlen(struct spi_slave *slave, unsigned int wordlen);
 int  spi_xfer(struct spi_slave *slave, unsigned int bitlen, const void *dout,
 		void *din, unsigned long flags);
 
+/**
+ * Read data from a SPI flash
+ *
+ * This sends the read command @cmd, including the address and dummy bytes,
+ * and then reads @data_len bytes with the chip select kept asserted. It
+ * uses the read_flash() operation of the controller, so that the command
+ * and data phases can be merged, and large reads can be done without the
+ * overhead of the generic transfers.
+ *
+ * @slave:	The SPI slave to read from
+ * @cmd:	Read command to send
+ * @cmd_len:	Length of the command in bytes
+ * @data:	Buffer for the data read
+ * @data_len:	Number of bytes to read
+ *
+ * Returns: 0 on success, -ENOSYS if the controller does not provide the
+ * operation (use spi_xfer() instead), other -ve value on failure
+ */
+#ifdef CONFIG_DM_SPI
+int spi_read_flash(struct spi_slave *slave, const u8 *cmd, size_t cmd_len,
+		   void *data, size_t data_len);
+#else
+static inline int spi_read_flash(struct spi_slave *slave, const u8 *cmd,
+				 size_t cmd_len, void *data, size_t data_len)
+{
+	return -ENOSYS;
+}
+#endif
+
 /* Copy memory mapped data */
 void spi_flash_copy_mmap(void *data, void *offset, size_t len);
 
@@ -402,6 +431,25 @@ struct dm_spi_ops {
 	int (*xfer)(struct udevice *dev, unsigned int bitlen, const void *dout,
 		    void *din, unsigned long flags);
 
+	/**
+	 * Read data from a SPI flash
+	 *
+	 * Optional. Sends @cmd_len bytes of @cmd and then reads @data_len
+	 * bytes into @data in a single chip select cycle. Controllers which
+	 * can chain the command and the data phases, or which have a faster
+	 * path for receiving large blocks, should implement this.
+	 *
+	 * @dev:	The slave device to read from
+	 * @cmd:	Read command, including the address and dummy bytes
+	 * @cmd_len:	Length of the command in bytes
+	 * @data:	Buffer for the data read
+	 * @data_len:	Number of bytes to read
+	 *
+	 * Returns: 0 on success, -ve on failure
+	 */
+	int (*read_flash)(struct udevice *dev, const u8 *cmd, size_t cmd_len,
+			  void *data, size_t data_len);
+
 	/**
 	 * Set transfer speed.
 	 * This sets a new speed to be applied for next spi_xfer().
@@ -0,0 +1,55 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Helpers shared by the unit tests which measure throughput
+ */
+
+#ifndef __TEST_BENCH_H
+#define __TEST_BENCH_H
+
+#include <linux/sizes.h>
+#include <linux/types.h>
+
+/* Each benchmark runs UT_BENCH_LOOPS times on a buffer larger than caches */
+#define UT_BENCH_SIZE		SZ_1M
+#define UT_BENCH_LOOPS		16
+
+/**
+ * ut_fill_pattern() - Fill a buffer with a non-repeating byte pattern
+ *
+ * @buf: Buffer to fill
+ * @len: Length of the buffer
+ * @seed: Value which selects the pattern
+ */
+void ut_fill_pattern(u8 *buf, size_t len, u8 seed);
+
+/**
+ * ut_bench_report_bytes() - Print the throughput of a benchmark
+ *
+ * @name: Name of the benchmark
+ * @start: Value of timer_get_us() at the start of the benchmark
+ * @bytes: Number of bytes processed by all loops of the benchmark
+ */
+void ut_bench_report_bytes(const char *name, ulong start, u64 bytes);
+
+/**
+ * ut_bench_report() - Print the throughput of a benchmark
+ *
+ * The benchmark is expected to have processed UT_BENCH_LOOPS times
+ * UT_BENCH_SIZE bytes.
+ *
+ * @name: Name of the benchmark
+ * @start: Value of timer_get_us() at the start of the benchmark
+ */
+void ut_bench_report(const char *name, ulong start);
+
+/**
+ * ut_bench_read_file() - Read a host file used as benchmark input (sandbox)
+ *
+ * @fname: Name of the file on the host
+ * @sizep: Returns the size of the file
+ * @return buffer allocated with malloc() holding the file, or NULL if the
+ *	file can not be read
+ */
+void *ut_bench_read_file(const char *fname, ulong *sizep);
+
+#endif
@@ -0,0 +1,14 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Tests for NAND mapped-block management (NMBM)
+ */
+
+#ifndef __TEST_NMBM_H__
+#define __TEST_NMBM_H__
+
+#include <test/test.h>
+
+/* Declare a new NMBM test */
+#define NMBM_TEST(_name, _flags)	UNIT_TEST(_name, _flags, nmbm_test)
+
+#endif /* __TEST_NMBM_H__ */
@@ -8,9 +8,29 @@
 #include <linux/kernel.h>
 #include <linux/types.h>
 
-static u16 LZ4_readLE16(const void *src) { return le16_to_cpu(*(u16 *)src); }
-static void LZ4_copy4(void *dst, const void *src) { *(u32 *)dst = *(u32 *)src; }
-static void LZ4_copy8(void *dst, const void *src) { *(u64 *)dst = *(u64 *)src; }
+/*
+ * Literals and matches are not aligned. Accesses through packed structures
+ * let the compiler use the unaligned load/store instructions of the CPU, as
+ * plain pointer accesses fault on strict-alignment CPUs such as MIPS.
+ */
+struct lz4_una_u16 { u16 x; } __packed;
+struct lz4_una_u32 { u32 x; } __packed;
+struct lz4_una_u64 { u64 x; } __packed;
+
+static u16 LZ4_readLE16(const void *src)
+{
+	return le16_to_cpu(((const struct lz4_una_u16 *)src)->x);
+}
+
+static void LZ4_copy4(void *dst, const void *src)
+{
+	((struct lz4_una_u32 *)dst)->x = ((const struct lz4_una_u32 *)src)->x;
+}
+
+static void LZ4_copy8(void *dst, const void *src)
+{
+	((struct lz4_una_u64 *)dst)->x = ((const struct lz4_una_u64 *)src)->x;
+}
 
 typedef  uint8_t BYTE;
 typedef uint16_t U16;
@@ -95,7 +115,7 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 	while (1) {
 		struct lz4_block_header b;
 
-		b.raw = le32_to_cpu(*(u32 *)in);
+		b.raw = le32_to_cpu(((const struct lz4_una_u32 *)in)->x);
 		in += sizeof(struct lz4_block_header);
 
 		if (in - src + b.size > srcn) {
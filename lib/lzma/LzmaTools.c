@@ -27,6 +27,9 @@
 #define LZMA_SIZE_OFFSET       LZMA_PROPS_SIZE
 #define LZMA_DATA_OFFSET       LZMA_SIZE_OFFSET+sizeof(uint64_t)
 
+/* Compressed data read at once by lzmaStreamToBuffDecompress */
+#define LZMA_STREAM_CHUNK_SIZE 0x4000
+
 #include "LzmaTools.h"
 #include "LzmaDec.h"
 
@@ -36,27 +39,13 @@
 static void *SzAlloc(void *p, size_t size) { return malloc(size); }
 static void SzFree(void *p, void *address) { free(address); }
 
-int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
-                  unsigned char *inStream,  SizeT  length)
+/* Read the uncompressed size from the LZMA_Alone header */
+static int lzmaGetUncompressedSize(const unsigned char *inStream,
+                                   SizeT *outSizeFull)
 {
-    int res = SZ_ERROR_DATA;
-    int i;
-    ISzAlloc g_Alloc;
-
-    SizeT outSizeFull = 0xFFFFFFFF; /* 4GBytes limit */
-    SizeT outProcessed;
     SizeT outSize;
     SizeT outSizeHigh;
-    ELzmaStatus state;
-    SizeT compressedSize = (SizeT)(length - LZMA_PROPS_SIZE);
-
-    debug ("LZMA: Image address............... 0x%p\n", inStream);
-    debug ("LZMA: Properties address.......... 0x%p\n", inStream + LZMA_PROPERTIES_OFFSET);
-    debug ("LZMA: Uncompressed size address... 0x%p\n", inStream + LZMA_SIZE_OFFSET);
-    debug ("LZMA: Compressed data address..... 0x%p\n", inStream + LZMA_DATA_OFFSET);
-    debug ("LZMA: Destination address......... 0x%p\n", outStream);
-
-    memset(&state, 0, sizeof(state));
+    int i;
 
     outSize = 0;
     outSizeHigh = 0;
@@ -70,13 +59,13 @@ int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
         }
     }
 
-    outSizeFull = (SizeT)outSize;
+    *outSizeFull = (SizeT)outSize;
     if (sizeof(SizeT) >= 8) {
         /*
          * SizeT is a 64 bit uint => We can manage files larger than 4GB!
          *
          */
-            outSizeFull |= (((SizeT)outSizeHigh << 16) << 16);
+            *outSizeFull |= (((SizeT)outSizeHigh << 16) << 16);
     } else if (outSizeHigh != 0 || (UInt32)(SizeT)outSize != outSize) {
         /*
          * SizeT is a 32 bit uint => We cannot manage files larger than
@@ -90,6 +79,32 @@ int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
         }
     }
 
+    return SZ_OK;
+}
+
+int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
+                  unsigned char *inStream,  SizeT  length)
+{
+    int res = SZ_ERROR_DATA;
+    ISzAlloc g_Alloc;
+
+    SizeT outSizeFull = 0xFFFFFFFF; /* 4GBytes limit */
+    SizeT outProcessed;
+    ELzmaStatus state;
+    SizeT compressedSize = (SizeT)(length - LZMA_PROPS_SIZE);
+
+    debug ("LZMA: Image address............... 0x%p\n", inStream);
+    debug ("LZMA: Properties address.......... 0x%p\n", inStream + LZMA_PROPERTIES_OFFSET);
+    debug ("LZMA: Uncompressed size address... 0x%p\n", inStream + LZMA_SIZE_OFFSET);
+    debug ("LZMA: Compressed data address..... 0x%p\n", inStream + LZMA_DATA_OFFSET);
+    debug ("LZMA: Destination address......... 0x%p\n", outStream);
+
+    memset(&state, 0, sizeof(state));
+
+    res = lzmaGetUncompressedSize(inStream, &outSizeFull);
+    if (res != SZ_OK)
+        return res;
+
     debug("LZMA: Uncompresed size............ 0x%zx\n", outSizeFull);
     debug("LZMA: Compresed size.............. 0x%zx\n", compressedSize);
 
@@ -120,4 +135,87 @@ int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
     return res;
 }
 
+int lzmaStreamToBuffDecompress(unsigned char *outStream,
+                               SizeT *uncompressedSize,
+                               lzma_read_func read, void *priv, SizeT length)
+{
+    unsigned char header[LZMA_DATA_OFFSET];
+    unsigned char *inBuf;
+    ISzAlloc g_Alloc;
+    CLzmaDec dec;
+    ELzmaStatus status = LZMA_STATUS_NOT_SPECIFIED;
+    SizeT outSizeFull;
+    SizeT inPos, inLen;
+    int res;
+
+    if (length < LZMA_DATA_OFFSET)
+        return SZ_ERROR_INPUT_EOF;
+
+    if (read(priv, 0, header, LZMA_DATA_OFFSET))
+        return SZ_ERROR_READ;
+
+    res = lzmaGetUncompressedSize(header, &outSizeFull);
+    if (res != SZ_OK)
+        return res;
+
+    debug("LZMA: Uncompresed size............ 0x%zx\n", outSizeFull);
+    debug("LZMA: Destination address......... 0x%p\n", outStream);
+
+    if (outSizeFull != (SizeT)-1 && *uncompressedSize < outSizeFull)
+        return SZ_ERROR_OUTPUT_EOF;
+
+    g_Alloc.Alloc = SzAlloc;
+    g_Alloc.Free = SzFree;
+
+    inBuf = malloc(LZMA_STREAM_CHUNK_SIZE);
+    if (!inBuf)
+        return SZ_ERROR_MEM;
+
+    LzmaDec_Construct(&dec);
+    res = LzmaDec_AllocateProbs(&dec, header, LZMA_PROPS_SIZE, &g_Alloc);
+    if (res != SZ_OK) {
+        free(inBuf);
+        return res;
+    }
+
+    /* The whole output buffer is the dictionary, nothing is copied twice */
+    dec.dic = outStream;
+    dec.dicBufSize = min(outSizeFull, *uncompressedSize);
+    LzmaDec_Init(&dec);
+
+    inPos = LZMA_DATA_OFFSET;
+    while (inPos < length) {
+        inLen = min((SizeT)LZMA_STREAM_CHUNK_SIZE, length - inPos);
+
+        if (read(priv, inPos, inBuf, inLen)) {
+            res = SZ_ERROR_READ;
+            break;
+        }
+
+        WATCHDOG_RESET();
+
+        res = LzmaDec_DecodeToDic(&dec, dec.dicBufSize, inBuf, &inLen,
+                                  LZMA_FINISH_END, &status);
+        if (res != SZ_OK)
+            break;
+
+        inPos += inLen;
+
+        if (status != LZMA_STATUS_NEEDS_MORE_INPUT)
+            break;
+    }
+
+    if (res == SZ_OK && status == LZMA_STATUS_NEEDS_MORE_INPUT)
+        res = SZ_ERROR_INPUT_EOF;
+
+    *uncompressedSize = dec.dicPos;
+
+    debug("LZMA: Uncompressed ............... 0x%zx\n", dec.dicPos);
+
+    LzmaDec_FreeProbs(&dec, &g_Alloc);
+    free(inBuf);
+
+    return res;
+}
+
 #endif
@@ -15,4 +15,20 @@
 
 extern int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
 			      unsigned char *inStream,  SizeT  length);
+
+/*
+ * Reads @len bytes at @offset of the compressed stream into @buf.
+ * Returns 0 on success.
+ */
+typedef int (*lzma_read_func)(void *priv, SizeT offset, void *buf, SizeT len);
+
+/*
+ * Same as lzmaBuffToBuffDecompress, but the compressed stream of @length
+ * bytes is fetched in small chunks through @read while it is decoded, so it
+ * does not need to be loaded into memory first.
+ */
+extern int lzmaStreamToBuffDecompress(unsigned char *outStream,
+				      SizeT *uncompressedSize,
+				      lzma_read_func read, void *priv,
+				      SizeT length);
 #endif
@@ -36,9 +36,9 @@
 static void
 MD5Transform(__u32 buf[4], __u32 const in[16]);
 
-/*
- * Note: this code is harmless on little-endian machines.
- */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+#define byteReverse(buf, len)	/* Nothing */
+#else
 static void
 byteReverse(unsigned char *buf, unsigned longs)
 {
@@ -50,12 +50,13 @@ byteReverse(unsigned char *buf, unsigned longs)
 		buf += 4;
 	} while (--longs);
 }
+#endif
 
 /*
  * Start MD5 accumulation.  Set bit count to 0 and buffer to mysterious
  * initialization constants.
  */
-static void
+void
 MD5Init(struct MD5Context *ctx)
 {
 	ctx->buf[0] = 0x67452301;
@@ -71,7 +72,7 @@ MD5Init(struct MD5Context *ctx)
  * Update context to reflect the concatenation of another buffer full
  * of bytes.
  */
-static void
+void
 MD5Update(struct MD5Context *ctx, unsigned char const *buf, unsigned len)
 {
 	register __u32 t;
@@ -104,6 +105,15 @@ MD5Update(struct MD5Context *ctx, unsigned char const *buf, unsigned len)
 	/* Process data in 64-byte chunks */
 
 	while (len >= 64) {
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+		/* Aligned input is already in the layout MD5Transform wants */
+		if (!((unsigned long)buf & 3)) {
+			MD5Transform(ctx->buf, (__u32 const *) buf);
+			buf += 64;
+			len -= 64;
+			continue;
+		}
+#endif
 		memmove(ctx->in, buf, 64);
 		byteReverse(ctx->in, 16);
 		MD5Transform(ctx->buf, (__u32 *) ctx->in);
@@ -120,7 +130,7 @@ MD5Update(struct MD5Context *ctx, unsigned char const *buf, unsigned len)
  * Final wrapup - pad to 64-byte boundary with the bit pattern
  * 1 0* (64-bit count of bits processed, MSB-first)
  */
-static void
+void
 MD5Final(unsigned char digest[16], struct MD5Context *ctx)
 {
 	unsigned int count;
@@ -23,14 +23,6 @@ const uint8_t sha256_der_prefix[SHA256_DER_LEN] = {
 /*
  * 32-bit integer manipulation macros (big endian)
  */
-#ifndef GET_UINT32_BE
-#define GET_UINT32_BE(n,b,i) {				\
-	(n) = ( (unsigned long) (b)[(i)    ] << 24 )	\
-	    | ( (unsigned long) (b)[(i) + 1] << 16 )	\
-	    | ( (unsigned long) (b)[(i) + 2] <<  8 )	\
-	    | ( (unsigned long) (b)[(i) + 3]       );	\
-}
-#endif
 #ifndef PUT_UINT32_BE
 #define PUT_UINT32_BE(n,b,i) {				\
 	(b)[(i)    ] = (unsigned char) ( (n) >> 24 );	\
@@ -55,28 +47,33 @@ void sha256_starts(sha256_context * ctx)
 	ctx->state[7] = 0x5BE0CD19;
 }
 
+/*
+ * The block is loaded a word at a time, so data must be word aligned.
+ * sha256_update() copies unaligned input to ctx->buffer first.
+ */
 static void sha256_process(sha256_context *ctx, const uint8_t data[64])
 {
 	uint32_t temp1, temp2;
 	uint32_t W[64];
 	uint32_t A, B, C, D, E, F, G, H;
-
-	GET_UINT32_BE(W[0], data, 0);
-	GET_UINT32_BE(W[1], data, 4);
-	GET_UINT32_BE(W[2], data, 8);
-	GET_UINT32_BE(W[3], data, 12);
-	GET_UINT32_BE(W[4], data, 16);
-	GET_UINT32_BE(W[5], data, 20);
-	GET_UINT32_BE(W[6], data, 24);
-	GET_UINT32_BE(W[7], data, 28);
-	GET_UINT32_BE(W[8], data, 32);
-	GET_UINT32_BE(W[9], data, 36);
-	GET_UINT32_BE(W[10], data, 40);
-	GET_UINT32_BE(W[11], data, 44);
-	GET_UINT32_BE(W[12], data, 48);
-	GET_UINT32_BE(W[13], data, 52);
-	GET_UINT32_BE(W[14], data, 56);
-	GET_UINT32_BE(W[15], data, 60);
+	const uint32_t *in = (const uint32_t *)data;
+
+	W[0] = be32_to_cpu(in[0]);
+	W[1] = be32_to_cpu(in[1]);
+	W[2] = be32_to_cpu(in[2]);
+	W[3] = be32_to_cpu(in[3]);
+	W[4] = be32_to_cpu(in[4]);
+	W[5] = be32_to_cpu(in[5]);
+	W[6] = be32_to_cpu(in[6]);
+	W[7] = be32_to_cpu(in[7]);
+	W[8] = be32_to_cpu(in[8]);
+	W[9] = be32_to_cpu(in[9]);
+	W[10] = be32_to_cpu(in[10]);
+	W[11] = be32_to_cpu(in[11]);
+	W[12] = be32_to_cpu(in[12]);
+	W[13] = be32_to_cpu(in[13]);
+	W[14] = be32_to_cpu(in[14]);
+	W[15] = be32_to_cpu(in[15]);
 
 #define SHR(x,n) ((x & 0xFFFFFFFF) >> n)
 #define ROTR(x,n) (SHR(x,n) | (x << (32 - n)))
@@ -211,7 +208,12 @@ void sha256_update(sha256_context *ctx, const uint8_t *input, uint32_t length)
 	}
 
 	while (length >= 64) {
-		sha256_process(ctx, input);
+		if ((uintptr_t)input & 3) {
+			memcpy(ctx->buffer, input, 64);
+			sha256_process(ctx, ctx->buffer);
+		} else {
+			sha256_process(ctx, input);
+		}
 		length -= 64;
 		input += 64;
 	}
@@ -15,6 +15,9 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Maximum number of packets processed by one eth_rx() call */
+#define ETH_RX_BUDGET	32
+
 /**
  * struct eth_device_priv - private structure for each Ethernet device
  *
@@ -362,9 +365,22 @@ int eth_rx(void)
 	if (!eth_is_active(current))
 		return -EINVAL;
 
-	/* Process up to 32 packets at one time */
 	flags = ETH_RECV_CHECK_DEVICE;
-	for (i = 0; i < 32; i++) {
+
+	/* Let the driver process all packets at one time if possible */
+	if (eth_get_ops(current)->recv_burst) {
+		ret = eth_get_ops(current)->recv_burst(current, flags,
+						       ETH_RX_BUDGET);
+		if (ret == -EAGAIN)
+			ret = 0;
+		if (ret < 0)
+			debug("%s: recv_burst() returned error %d\n", __func__,
+			      ret);
+		return ret;
+	}
+
+	/* Process up to ETH_RX_BUDGET packets at one time */
+	for (i = 0; i < ETH_RX_BUDGET; i++) {
 		ret = eth_get_ops(current)->recv(current, flags, &packet);
 		flags = 0;
 		if (ret > 0)
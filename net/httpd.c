@@ -14,6 +14,11 @@
 #include <net.h>
 #include <net/tcp.h>
 #include <net/httpd.h>
+#include <u-boot/md5.h>
+#include <u-boot/sha256.h>
+
+/* Unused RAM region for request payloads which do not fit in the cache */
+#define HTTPD_UPLOAD_BUF	((char *)CONFIG_SYS_SDRAM_BASE + 0x10000)
 
 struct httpd_instance {
 	struct list_head node;
@@ -37,6 +42,48 @@ enum httpd_session_status {
 	HTTPD_S_CLOSING
 };
 
+enum httpd_stream_state {
+	HTTPD_STREAM_DATA = 0,
+	HTTPD_STREAM_DELIM_END,
+	HTTPD_STREAM_PART_HDR,
+	HTTPD_STREAM_EPILOGUE
+};
+
+struct httpd_upload_stream {
+	enum httpd_stream_state state;
+
+	/* CRLF "--" boundary */
+	char *delim;
+	u32 delimlen;
+
+	/* Length of delimiter prefix held from previous data */
+	u32 held;
+
+	char tail[2];
+	u32 taillen;
+
+	char hdr[1024];
+	u32 hdrlen;
+
+	/* Current part, NULL for preamble or ignored parts */
+	struct httpd_form_value *val;
+	int is_file;
+	int file_open;
+
+	/* Where file data is stored if there is no upload callback */
+	char *store;
+
+	/* Digests of the current file */
+	struct MD5Context md5;
+#ifdef CONFIG_HTTPD_UPLOAD_SHA256
+	sha256_context sha256;
+#endif
+
+	/* Storage for names and values of non-file parts */
+	char vbuf[2048];
+	u32 vlen;
+};
+
 struct httpd_tcp_pdata {
 	enum httpd_session_status status;
 
@@ -51,6 +98,8 @@ struct httpd_tcp_pdata {
 	u32 payload_size;
 	u32 upload_size;
 
+	struct httpd_upload_stream *stream;
+
 	struct httpd_request request;
 	struct httpd_response response;
 
@@ -83,6 +132,9 @@ static LIST_HEAD(inst_head);
 
 static void httpd_tcp_callback(struct tcb_cb_data *cbd);
 static void httpd_std_err_response(struct tcb_cb_data *cbd, u32 code);
+static int httpd_stream_init(struct httpd_tcp_pdata *pdata);
+static int httpd_recv_payload_stream(struct tcb_cb_data *cbd,
+				     const char *data, u32 len);
 
 static void dummy_urih_cb(enum httpd_uri_handler_status status,
 			  struct httpd_request *request,
@@ -171,6 +223,16 @@ int httpd_register_uri_handler(struct httpd_instance *httpd_inst,
 			       const char *uri,
 			       httpd_uri_handler_cb cb,
 			       struct httpd_uri_handler **returih)
+{
+	return httpd_register_uri_upload_handler(httpd_inst, uri, cb, NULL,
+						 returih);
+}
+
+int httpd_register_uri_upload_handler(struct httpd_instance *httpd_inst,
+				      const char *uri,
+				      httpd_uri_handler_cb cb,
+				      httpd_upload_cb upload_cb,
+				      struct httpd_uri_handler **returih)
 {
 	struct _httpd_uri_handler *u;
 
@@ -183,6 +245,7 @@ int httpd_register_uri_handler(struct httpd_instance *httpd_inst,
 
 	u->urih.uri = uri;
 	u->urih.cb = cb;
+	u->urih.upload_cb = upload_cb;
 
 	list_add_tail(&u->node, &httpd_inst->uri_handlers);
 
@@ -308,6 +371,7 @@ static int httpd_recv_hdr(struct httpd_instance *inst,
 	char *p, *payload_ptr, *uri_ptr, *fields_ptr;
 	char *cl_ptr, *ct_ptr, *b_ptr;
 	enum httpd_request_method method;
+	struct httpd_uri_handler *urih;
 	u32 size_rcvd, hdr_size, err_code = 400;
 	int ret = 0;
 
@@ -316,7 +380,8 @@ static int httpd_recv_hdr(struct httpd_instance *inst,
 	static const char boundary_str[] = "boundary=";
 
 	/* copy TCP data into cache */
-	size_rcvd = min(cbd->datalen, sizeof(pdata->buf) - pdata->bufsize - 1);
+	size_rcvd = min(cbd->datalen,
+			(u32)sizeof(pdata->buf) - pdata->bufsize - 1);
 
 	memcpy(pdata->buf + pdata->bufsize, cbd->data, size_rcvd);
 	pdata->bufsize += size_rcvd;
@@ -368,6 +433,8 @@ static int httpd_recv_hdr(struct httpd_instance *inst,
 		goto bad_request;
 	}
 
+	pdata->request.method = method;
+
 	/* extract uri */
 	p = strchr(uri_ptr, ' ');
 	if (!p)
@@ -426,6 +493,49 @@ static int httpd_recv_hdr(struct httpd_instance *inst,
 			debug("    Content-Type: boundary=\"%s\"\n", b_ptr);
 		}
 
+		/*
+		 * Files are passed to the upload handler, or stored if the
+		 * payload does not fit in the cache, while being received.
+		 * This also computes their digests on the fly.
+		 */
+		urih = httpd_find_uri_handler(inst, pdata->uri);
+		if (urih && pdata->boundary && (urih->upload_cb ||
+		    hdr_size + pdata->payload_size >= sizeof(pdata->buf))) {
+			if (is_uploading) {
+				printf("Only one upload can be performed\n");
+				tcp_close_conn(cbd->conn, 1);
+				return 1;
+			}
+
+			if (httpd_stream_init(pdata)) {
+				err_code = 500;
+				goto bad_request;
+			}
+
+			/* generate new upload identifier */
+			upload_id = rand();
+
+			pdata->request.urih = urih;
+			pdata->status = HTTPD_S_PAYLOAD_RECVING;
+			pdata->is_uploading = 1;
+			is_uploading = 1;
+
+			ret = httpd_recv_payload_stream(cbd,
+				pdata->buf + hdr_size,
+				pdata->bufsize - hdr_size);
+			if (ret < 0)
+				return 1;
+
+			if (ret && size_rcvd < cbd->datalen) {
+				/* TCP data which is not copied into cache */
+				ret = httpd_recv_payload_stream(cbd,
+					(char *) cbd->data + size_rcvd,
+					cbd->datalen - size_rcvd);
+			}
+
+			return ret != 0;
+		}
+
 		if (hdr_size + pdata->payload_size < sizeof(pdata->buf)) {
 			/* upload payload can be put into the cache */
 			pdata->upload_ptr = pdata->buf + hdr_size;
@@ -442,8 +552,7 @@ static int httpd_recv_hdr(struct httpd_instance *inst,
 			upload_id = rand();
 
 			/* calculate new cache address */
-			pdata->upload_ptr =
-				(char *) CONFIG_SYS_SDRAM_BASE + 0x10000;
+			pdata->upload_ptr = HTTPD_UPLOAD_BUF;
 			pdata->upload_size = pdata->bufsize - hdr_size;
 			/* copy received parts to new cache */
 			memcpy(pdata->upload_ptr, pdata->buf + hdr_size,
@@ -474,8 +583,6 @@ static int httpd_recv_hdr(struct httpd_instance *inst,
 		pdata->status = HTTPD_S_FULL_RCVD;
 	}
 
-	pdata->request.method = method;
-
 	return ret;
 
 bad_request:
@@ -489,6 +596,10 @@ static int httpd_recv_payload(struct httpd_instance *inst,
 	struct httpd_tcp_pdata *pdata = cbd->pdata;
 	u32 size_recv;
 
+	if (pdata->stream)
+		return httpd_recv_payload_stream(cbd, cbd->data,
+						 cbd->datalen) != 0;
+
 	size_recv = min(pdata->payload_size - pdata->upload_size, cbd->datalen);
 	memcpy(pdata->upload_ptr + pdata->upload_size, cbd->data, size_recv);
 	pdata->upload_size += size_recv;
@@ -544,6 +655,382 @@ static char *name_extract(char *s)
 	return name;
 }
 
+static int httpd_stream_init(struct httpd_tcp_pdata *pdata)
+{
+	struct httpd_upload_stream *s;
+	u32 boundarylen;
+
+	boundarylen = strlen(pdata->boundary);
+
+	s = calloc(1, sizeof(*s) + boundarylen + 5);
+	if (!s)
+		return -ENOMEM;
+
+	/* delimiter is CRLF followed by "--" and the boundary */
+	s->delim = (char *)(s + 1);
+	s->delimlen = boundarylen + 4;
+	memcpy(s->delim, "\r\n--", 4);
+	memcpy(s->delim + 4, pdata->boundary, boundarylen + 1);
+
+	/*
+	 * The first boundary has no leading CRLF. Treat the CRLF as received
+	 * so that the preamble is handled as an ignored part.
+	 */
+	s->state = HTTPD_STREAM_DATA;
+	s->held = 2;
+
+	s->store = HTTPD_UPLOAD_BUF;
+
+	pdata->stream = s;
+
+	return 0;
+}
+
+static void httpd_stream_abort(struct httpd_tcp_pdata *pdata)
+{
+	struct httpd_upload_stream *s = pdata->stream;
+	struct httpd_request *req = &pdata->request;
+
+	if (!s || !s->file_open)
+		return;
+
+	s->file_open = 0;
+	req->urih->upload_cb(HTTP_UPLOAD_ABORT, req, s->val, NULL, 0);
+}
+
+static char *httpd_stream_strdup(struct httpd_upload_stream *s,
+				 const char *str)
+{
+	u32 len = strlen(str) + 1;
+	char *p;
+
+	if (s->vlen + len > sizeof(s->vbuf))
+		return NULL;
+
+	p = s->vbuf + s->vlen;
+	memcpy(p, str, len);
+	s->vlen += len;
+
+	return p;
+}
+
+static int httpd_stream_emit(struct httpd_tcp_pdata *pdata, const char *data,
+			     u32 len)
+{
+	struct httpd_upload_stream *s = pdata->stream;
+	struct httpd_request *req = &pdata->request;
+
+	if (!s->val || !len)
+		return 0;
+
+	s->val->size += len;
+
+	if (s->is_file) {
+		MD5Update(&s->md5, (const unsigned char *)data, len);
+#ifdef CONFIG_HTTPD_UPLOAD_SHA256
+		sha256_update(&s->sha256, (const uint8_t *)data, len);
+#endif
+
+		if (!req->urih->upload_cb) {
+			memcpy(s->store, data, len);
+			s->store += len;
+		} else if (s->file_open && req->urih->upload_cb(
+				HTTP_UPLOAD_DATA, req, s->val, data, len)) {
+			s->file_open = 0;
+		}
+		return 0;
+	}
+
+	/* Reserve one byte for the terminating null */
+	if (s->vlen + len + 1 > sizeof(s->vbuf))
+		return -1;
+
+	memcpy(s->vbuf + s->vlen, data, len);
+	s->vlen += len;
+
+	return 0;
+}
+
+static int httpd_stream_part_start(struct httpd_tcp_pdata *pdata)
+{
+	struct httpd_upload_stream *s = pdata->stream;
+	struct httpd_request *req = &pdata->request;
+	struct httpd_form_value *val;
+	char *name_ptr, *filename_ptr;
+
+	static const char name_str[] = "name=";
+	static const char filename_str[] = "filename=";
+
+	s->val = NULL;
+	s->is_file = 0;
+
+	if (req->form.count >= MAX_HTTP_FORM_VALUE_ITEMS)
+		return 0;
+
+	/* Parts without a name can not be looked up, ignore them */
+	name_ptr = strstr(s->hdr, name_str);
+	if (!name_ptr)
+		return 0;
+
+	val = &req->form.values[req->form.count];
+	memset(val, 0, sizeof(*val));
+
+	filename_ptr = strstr(s->hdr, filename_str);
+
+	name_ptr += sizeof(name_str) - 1;
+	val->name = httpd_stream_strdup(s, name_extract(name_ptr));
+	if (!val->name)
+		return -1;
+
+	if (filename_ptr) {
+		filename_ptr += sizeof(filename_str) - 1;
+		val->filename = httpd_stream_strdup(s,
+			name_extract(filename_ptr));
+		if (!val->filename)
+			return -1;
+
+		s->is_file = 1;
+	} else {
+		val->data = s->vbuf + s->vlen;
+	}
+
+	req->form.count++;
+	s->val = val;
+
+	if (s->is_file) {
+		MD5Init(&s->md5);
+#ifdef CONFIG_HTTPD_UPLOAD_SHA256
+		sha256_starts(&s->sha256);
+#endif
+
+		if (req->urih->upload_cb)
+			s->file_open = !req->urih->upload_cb(HTTP_UPLOAD_START,
+							     req, val, NULL, 0);
+		else
+			val->data = s->store;
+	}
+
+	return 0;
+}
+
+static void httpd_stream_part_end(struct httpd_tcp_pdata *pdata)
+{
+	struct httpd_upload_stream *s = pdata->stream;
+	struct httpd_request *req = &pdata->request;
+
+	if (!s->val)
+		return;
+
+	if (s->is_file) {
+		MD5Final(s->val->md5, &s->md5);
+#ifdef CONFIG_HTTPD_UPLOAD_SHA256
+		sha256_finish(&s->sha256, s->val->sha256);
+#endif
+
+		if (s->file_open) {
+			s->file_open = 0;
+			req->urih->upload_cb(HTTP_UPLOAD_END, req, s->val,
+					     NULL, 0);
+		}
+	} else {
+		s->vbuf[s->vlen++] = 0;
+	}
+
+	s->val = NULL;
+}
+
+/* Process part data and look for the delimiter. Returns bytes consumed */
+static int httpd_stream_data(struct httpd_tcp_pdata *pdata, const char *data,
+			     u32 len)
+{
+	struct httpd_upload_stream *s = pdata->stream;
+	const char *p, *end = data + len;
+	u32 n, i;
+
+	/* Check whether the held delimiter prefix continues in new data */
+	while (s->held) {
+		n = min(len, s->delimlen - s->held);
+
+		if (!memcmp(data, s->delim + s->held, n)) {
+			if (s->held + n < s->delimlen) {
+				s->held += n;
+				return n;
+			}
+
+			s->held = 0;
+			httpd_stream_part_end(pdata);
+			s->state = HTTPD_STREAM_DELIM_END;
+			s->taillen = 0;
+			return n;
+		}
+
+		/*
+		 * Not a delimiter. Emit held bytes up to the next position
+		 * which can still be the start of a delimiter.
+		 */
+		for (i = 1; i < s->held; i++) {
+			if (!memcmp(s->delim + i, s->delim, s->held - i))
+				break;
+		}
+
+		if (httpd_stream_emit(pdata, s->delim, i))
+			return -1;
+
+		s->held -= i;
+	}
+
+	for (p = data; p < end; p++) {
+		p = memchr(p, '\r', end - p);
+		if (!p)
+			break;
+
+		n = min((u32)(end - p), s->delimlen);
+		if (memcmp(p, s->delim, n))
+			continue;
+
+		if (httpd_stream_emit(pdata, data, p - data))
+			return -1;
+
+		if (n < s->delimlen) {
+			/* Delimiter may continue in next data */
+			s->held = n;
+			return len;
+		}
+
+		httpd_stream_part_end(pdata);
+		s->state = HTTPD_STREAM_DELIM_END;
+		s->taillen = 0;
+
+		return p - data + n;
+	}
+
+	if (httpd_stream_emit(pdata, data, len))
+		return -1;
+
+	return len;
+}
+
+/* Collect part header. Returns bytes consumed */
+static int httpd_stream_part_hdr(struct httpd_tcp_pdata *pdata,
+				 const char *data, u32 len)
+{
+	struct httpd_upload_stream *s = pdata->stream;
+	u32 n, start;
+	char *p;
+
+	n = min(len, (u32)sizeof(s->hdr) - s->hdrlen - 1);
+	if (!n)
+		return -1;
+
+	start = s->hdrlen > 3 ? s->hdrlen - 3 : 0;
+
+	memcpy(s->hdr + s->hdrlen, data, n);
+	s->hdrlen += n;
+	s->hdr[s->hdrlen] = 0;
+
+	p = strstr(s->hdr + start, "\r\n\r\n");
+	if (!p)
+		return n;
+
+	/* Only consume the bytes belonging to this header */
+	n -= s->hdrlen - (p + 4 - s->hdr);
+	*p = 0;
+
+	if (httpd_stream_part_start(pdata))
+		return -1;
+
+	s->state = HTTPD_STREAM_DATA;
+
+	return n;
+}
+
+static int httpd_stream_feed(struct httpd_tcp_pdata *pdata, const char *data,
+			     u32 len)
+{
+	struct httpd_upload_stream *s = pdata->stream;
+	int n;
+
+	while (len) {
+		switch (s->state) {
+		case HTTPD_STREAM_DATA:
+			n = httpd_stream_data(pdata, data, len);
+			break;
+		case HTTPD_STREAM_DELIM_END:
+			s->tail[s->taillen++] = *data;
+			n = 1;
+
+			if (s->taillen < sizeof(s->tail))
+				break;
+
+			if (!memcmp(s->tail, "\r\n", 2)) {
+				/*
+				 * Keep the CRLF ending the delimiter line, so
+				 * that an empty header block also ends with
+				 * CRLF CRLF
+				 */
+				s->state = HTTPD_STREAM_PART_HDR;
+				memcpy(s->hdr, "\r\n", 2);
+				s->hdrlen = 2;
+			} else if (!memcmp(s->tail, "--", 2)) {
+				s->state = HTTPD_STREAM_EPILOGUE;
+			} else {
+				n = -1;
+			}
+			break;
+		case HTTPD_STREAM_PART_HDR:
+			n = httpd_stream_part_hdr(pdata, data, len);
+			break;
+		default:
+			/* Discard epilogue */
+			n = len;
+		}
+
+		if (n < 0)
+			return -1;
+
+		data += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+/*
+ * Returns 0 if the payload has been fully received, 1 if more data is
+ * expected, or -1 if the request is bad and has been answered with 400
+ */
+static int httpd_recv_payload_stream(struct tcb_cb_data *cbd,
+				     const char *data, u32 len)
+{
+	struct httpd_tcp_pdata *pdata = cbd->pdata;
+
+	len = min(pdata->payload_size - pdata->upload_size, len);
+
+	if (httpd_stream_feed(pdata, data, len)) {
+		httpd_stream_abort(pdata);
+		pdata->is_uploading = 0;
+		is_uploading = 0;
+		httpd_std_err_response(cbd, 400);
+		return -1;
+	}
+
+	pdata->upload_size += len;
+
+	if (pdata->upload_size < pdata->payload_size)
+		return 1;
+
+	/* Truncated request body */
+	if (pdata->stream->state != HTTPD_STREAM_EPILOGUE)
+		httpd_stream_abort(pdata);
+
+	pdata->status = HTTPD_S_FULL_RCVD;
+	/* remove uploading mark */
+	pdata->is_uploading = 0;
+	is_uploading = 0;
+
+	return 0;
+}
+
 static int httpd_handle_request(struct httpd_instance *inst,
 				 struct tcb_cb_data *cbd)
 {
@@ -565,7 +1052,8 @@ static int httpd_handle_request(struct httpd_instance *inst,
 		return 1;
 	}
 
-	if (req->method == HTTP_POST) {
+	/* form values of streamed request have been parsed while receiving */
+	if (req->method == HTTP_POST && !pdata->stream) {
 		boundarylen = strlen(pdata->boundary);
 		boundary = malloc(boundarylen + 3);
 		if (!boundary) {
@@ -630,6 +1118,17 @@ static int httpd_handle_request(struct httpd_instance *inst,
 			}
 
 			val->size = formdata_end[i] - val->data;
+
+			if (val->filename) {
+				md5((unsigned char *)val->data, val->size,
+				    val->md5);
+#ifdef CONFIG_HTTPD_UPLOAD_SHA256
+				sha256_csum_wd((const unsigned char *)val->data,
+					       val->size, val->sha256,
+					       CHUNKSZ_SHA256);
+#endif
+			}
+
 			req->form.count++;
 		}
 
@@ -739,12 +1238,16 @@ static void httpd_cleanup(struct httpd_instance *inst, struct tcb_cb_data *cbd)
 	if (pdata->is_uploading)
 		is_uploading = 0;
 
+	/* connection closed while receiving a file */
+	httpd_stream_abort(pdata);
+
 	/* call uri handler */
 	if (req->urih) {
 		assert((size_t) req->urih->cb > CONFIG_SYS_SDRAM_BASE);
 		req->urih->cb(HTTP_CB_CLOSED, req, resp);
 	}
 
+	free(pdata->stream);
 	free(pdata);
 }
 
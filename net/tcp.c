@@ -20,6 +20,22 @@
 #include "arp.h"
 #include "tcp.h"
 
+/* A segment which has been sent but not yet ACKed */
+struct tcp_seg {
+	u32 seq;
+	u32 len;
+	u32 ts;
+	int rexmit;
+};
+
+/* A segment which has been received out of order */
+struct tcp_ooo_seg {
+	u32 seq;
+	u32 len;
+	int fin;
+	u8 *data;
+};
+
 struct tcp_conn {
 	struct list_head node;
 
@@ -33,6 +49,7 @@ struct tcp_conn {
 	u32 local_seq;
 	u32 local_seq_last;
 	u32 local_seq_acked;
+	u32 local_seq_max;
 
 	u32 ts;
 	u32 ts_rexmit;
@@ -48,18 +65,31 @@ struct tcp_conn {
 	int close_flag;
 	int ack_flag;
 
-	int rexmit_mode;
-	int rexmit_wait_ack;
-
 	int zw_mode;
 	u32 peer_wnd;
 	u32 peer_ws;
+	u32 rcv_ws;
+
+	u32 rcv_unacked;
+	u32 ts_delack;
+
+	struct tcp_ooo_seg ooo[TCP_OOO_SEGS_MAX];
+	u32 ooo_num;
+
+	u32 cwnd;
+	u32 ssthresh;
+	u32 dup_acks;
+	u32 recover;
+	int fast_recovery;
+
+	struct tcp_seg segs[TCP_TX_SEGS_MAX];
+	u32 seg_head;
+	u32 seg_num;
 
 	u32 srtt;
 	u32 rttvar;
 	u32 rto;
 	u32 ts_rtt;
-	u32 ack_calc_rtt;
 
 	void *pdata;
 };
@@ -82,6 +112,8 @@ static LIST_HEAD(conn_head);
 
 static int tcp_stop;
 
+static struct tcp_stats tcp_stats;
+
 void tcp_start(void)
 {
 	tcp_stop = 0;
@@ -156,6 +188,11 @@ static struct tcp_conn *tcp_conn_find(__be32 remoteip, __be16 remoteport,
 
 static void tcp_conn_del(struct tcp_conn *c)
 {
+	u32 i;
+
+	for (i = 0; i < c->ooo_num; i++)
+		free(c->ooo[i].data);
+
 	list_del(&c->node);
 	free(c);
 }
@@ -220,9 +257,8 @@ static int tcp_seq_sub(ulong a, ulong b)
 	}
 }
 
-static void rtt_calc(struct tcp_conn *c)
+static void rtt_calc(struct tcp_conn *c, u32 rtt)
 {
-	u32 rtt = get_timer(c->ts_rtt);
 	u32 sub;
 
 	if (rtt > c->srtt)
@@ -236,18 +272,32 @@ static void rtt_calc(struct tcp_conn *c)
 	c->rto = c->srtt + max((u32) TCP_RTT_G, TCP_RTT_K * c->rttvar);
 }
 
-static void tcp_set_mss_opt(u8 *opt, u16 mss)
+static void tcp_set_mss_opt(u8 *opt, struct tcp_conn *c)
 {
 	opt[0] = TCP_OPT_MSS;
 	opt[1] = 4;
-	opt[2] = (mss >> 8) & 0xff;
-	opt[3] = mss & 0xff;
-	opt[4] = TCP_OPT_WS;
-	opt[5] = 3;
-	opt[6] = 0;
+	opt[2] = (c->mss >> 8) & 0xff;
+	opt[3] = c->mss & 0xff;
+
+	if (c->rcv_ws) {
+		/* Window scaling is used only if the peer also offered it */
+		opt[4] = TCP_OPT_WS;
+		opt[5] = 3;
+		opt[6] = c->rcv_ws;
+	} else {
+		opt[4] = TCP_OPT_EOL;
+		opt[5] = TCP_OPT_EOL;
+		opt[6] = TCP_OPT_EOL;
+	}
+
 	opt[7] = TCP_OPT_EOL;
 }
 
+static u32 tcp_rcv_wnd(struct tcp_conn *c)
+{
+	return min((u32) TCP_RCV_WND >> c->rcv_ws, 0xffffU) << c->rcv_ws;
+}
+
 static struct tcp_conn *tcp_conn_create(__be32 remoteip, struct tcp_hdr *tcp,
 	u32 tcphdr_len, u8 *ethaddr, tcp_conn_cb cb)
 {
@@ -293,6 +343,9 @@ static struct tcp_conn *tcp_conn_create(__be32 remoteip, struct tcp_hdr *tcp,
 				continue;
 			}
 
+			if (o + 1 >= optend || o[1] < 2)
+				break;
+
 			switch (*o) {
 			case TCP_OPT_MSS:
 				mss = ((u16) o[2] << 8) | o[3];
@@ -301,6 +354,7 @@ static struct tcp_conn *tcp_conn_create(__be32 remoteip, struct tcp_hdr *tcp,
 				break;
 			case TCP_OPT_WS:
 				c->peer_ws = min((u32) o[2], 14U);
+				c->rcv_ws = TCP_RCV_WS;
 				break;
 			}
 
@@ -309,7 +363,7 @@ static struct tcp_conn *tcp_conn_create(__be32 remoteip, struct tcp_hdr *tcp,
 	}
 
 	/* send first SYN ACK packet */
-	tcp_set_mss_opt(opt, c->mss);
+	tcp_set_mss_opt(opt, c);
 
 	tcp_send_packet_opt(c, TCP_SYN | TCP_ACK,
 		c->local_seq, c->peer_seq + 1, opt, sizeof(opt), NULL, 0);
@@ -321,6 +375,305 @@ static struct tcp_conn *tcp_conn_create(__be32 remoteip, struct tcp_hdr *tcp,
 	return c;
 }
 
+static void tcp_rexmit_init(struct tcp_conn *c)
+{
+	c->ts_rexmit = get_timer(0);
+	c->ts = get_timer(0);
+	c->num_rexmit = 0;
+}
+
+static void tcp_rexmit_reset(struct tcp_conn *c)
+{
+	c->ts = get_timer(0);
+	c->num_rexmit++;
+}
+
+static void tcp_send_seg(struct tcp_conn *c, u32 seq, u32 len)
+{
+	u32 offset = tcp_seq_sub(seq, c->local_seq_last);
+	u16 flags = TCP_ACK;
+
+	if (offset + len == c->txlen)
+		flags |= TCP_PSH;
+
+	tcp_send_packet(c, flags, seq, c->peer_seq, c->tx + offset, len);
+}
+
+static void tcp_send_new_seg(struct tcp_conn *c, u32 len)
+{
+	struct tcp_seg *seg;
+
+	seg = &c->segs[(c->seg_head + c->seg_num) % TCP_TX_SEGS_MAX];
+	seg->seq = c->local_seq;
+	seg->len = len;
+	seg->ts = get_timer(0);
+	seg->rexmit = tcp_seq_sub(c->local_seq, c->local_seq_max) < 0;
+
+	if (seg->rexmit)
+		tcp_stats.rexmits++;
+
+	if (!c->seg_num) {
+		/* Start the retransmission timer */
+		c->ts = seg->ts;
+		if (!c->num_rexmit)
+			c->ts_rexmit = seg->ts;
+	}
+
+	c->seg_num++;
+
+	tcp_send_seg(c, seg->seq, len);
+
+	c->local_seq += len;
+	if (tcp_seq_sub(c->local_seq, c->local_seq_max) > 0)
+		c->local_seq_max = c->local_seq;
+}
+
+static void tcp_rexmit_first_seg(struct tcp_conn *c)
+{
+	struct tcp_seg *seg;
+
+	if (!c->seg_num)
+		return;
+
+	seg = &c->segs[c->seg_head];
+	seg->rexmit = 1;
+	seg->ts = get_timer(0);
+
+	tcp_stats.rexmits++;
+
+	tcp_send_seg(c, seg->seq, seg->len);
+}
+
+static void tcp_ack_update(struct tcp_conn *c, u32 ack)
+{
+	u32 acked = tcp_seq_sub(ack, c->local_seq_acked);
+	u32 rtt = 0, cwnd_max;
+	struct tcp_seg *seg;
+	int rtt_valid = 0;
+
+	c->local_seq_acked = ack;
+
+	/* Segments sent before a timeout may be ACKed after going back */
+	if (tcp_seq_sub(ack, c->local_seq) > 0)
+		c->local_seq = ack;
+
+	/*
+	 * Release fully ACKed segments. Only segments which have never been
+	 * retransmitted can be used for RTT sampling (Karn's algorithm)
+	 */
+	while (c->seg_num) {
+		seg = &c->segs[c->seg_head];
+		if (tcp_seq_sub(seg->seq + seg->len, ack) > 0)
+			break;
+
+		if (!seg->rexmit) {
+			rtt = get_timer(seg->ts);
+			rtt_valid = 1;
+		}
+
+		c->seg_head = (c->seg_head + 1) % TCP_TX_SEGS_MAX;
+		c->seg_num--;
+	}
+
+	if (rtt_valid)
+		rtt_calc(c, rtt);
+
+	if (c->fast_recovery) {
+		if (tcp_seq_sub(ack, c->recover) >= 0) {
+			/* All data sent before the loss is ACKed */
+			c->fast_recovery = 0;
+			c->cwnd = c->ssthresh;
+		} else {
+			/* Partial ACK, the next segment is lost too */
+			tcp_rexmit_first_seg(c);
+			c->cwnd = (c->cwnd > acked ? c->cwnd - acked : 0) +
+				c->mss;
+		}
+	} else if (c->cwnd < c->ssthresh) {
+		/* Slow start */
+		c->cwnd += min(acked, (u32) c->mss);
+	} else {
+		/* Congestion avoidance */
+		c->cwnd += max((u32) c->mss * c->mss / c->cwnd, 1U);
+	}
+
+	cwnd_max = TCP_TX_SEGS_MAX * c->mss;
+	if (c->cwnd > cwnd_max)
+		c->cwnd = cwnd_max;
+
+	c->dup_acks = 0;
+	tcp_rexmit_init(c);
+}
+
+static void tcp_dup_ack(struct tcp_conn *c)
+{
+	u32 inflight;
+
+	c->dup_acks++;
+	tcp_stats.dup_acks_in++;
+
+	if (c->fast_recovery) {
+		/* Every duplicated ACK means one segment has left the network */
+		c->cwnd += c->mss;
+		return;
+	}
+
+	if (c->dup_acks != TCP_DUPACK_THRESH)
+		return;
+
+	/* Do not enter fast recovery twice for the same window */
+	if (tcp_seq_sub(c->local_seq_acked, c->recover) < 0)
+		return;
+
+	/* Fast retransmit */
+	inflight = tcp_seq_sub(c->local_seq, c->local_seq_acked);
+	c->ssthresh = max(inflight / 2, 2U * c->mss);
+	c->cwnd = c->ssthresh + TCP_DUPACK_THRESH * c->mss;
+	c->recover = c->local_seq_max;
+	c->fast_recovery = 1;
+
+	tcp_stats.fast_rexmits++;
+	tcp_rexmit_first_seg(c);
+	c->ts = get_timer(0);
+}
+
+static void tcp_rexmit_timeout(struct tcp_conn *c)
+{
+	u32 inflight;
+
+	tcp_stats.rexmit_timeouts++;
+
+	if (!c->zw_mode) {
+		inflight = tcp_seq_sub(c->local_seq, c->local_seq_acked);
+		c->ssthresh = max(inflight / 2, 2U * c->mss);
+		c->cwnd = c->mss;
+	}
+
+	/* Go back to the first unACKed byte */
+	c->fast_recovery = 0;
+	c->dup_acks = 0;
+	c->seg_num = 0;
+	c->local_seq = c->local_seq_acked;
+
+	tcp_rexmit_reset(c);
+}
+
+static void tcp_send_window(struct tcp_conn *c)
+{
+	u32 sent, inflight, wnd, len;
+
+	while (c->tx && c->seg_num < TCP_TX_SEGS_MAX) {
+		sent = tcp_seq_sub(c->local_seq, c->local_seq_last);
+		if (sent >= c->txlen)
+			break;
+
+		inflight = tcp_seq_sub(c->local_seq, c->local_seq_acked);
+		wnd = min(c->cwnd, c->peer_wnd);
+		if (inflight >= wnd)
+			break;
+
+		len = min3(c->txlen - sent, (u32) c->mss, wnd - inflight);
+
+		/* Avoid sending small segments while data is in flight */
+		if (len < c->mss && len < c->txlen - sent && inflight)
+			break;
+
+		tcp_send_new_seg(c, len);
+	}
+}
+
+static void tcp_ooo_queue(struct tcp_conn *c, u32 seq, const u8 *data,
+	u32 len, int fin)
+{
+	struct tcp_ooo_seg *s;
+	u8 *buf = NULL;
+	u32 i;
+
+	/* Segments beyond the advertised window are not acceptable */
+	if (tcp_seq_sub(seq + len, c->peer_seq) > (int) tcp_rcv_wnd(c)) {
+		tcp_stats.ooo_drops++;
+		return;
+	}
+
+	/* Find the insertion point, the queue is sorted by SEQ */
+	for (i = 0; i < c->ooo_num; i++) {
+		s = &c->ooo[i];
+
+		if (tcp_seq_sub(seq, s->seq) < 0)
+			break;
+
+		if (seq == s->seq && len <= s->len && (!fin || s->fin))
+			/* Retransmission of a queued segment */
+			return;
+	}
+
+	if (c->ooo_num >= TCP_OOO_SEGS_MAX) {
+		tcp_stats.ooo_drops++;
+		return;
+	}
+
+	if (len) {
+		buf = malloc(len);
+		if (!buf) {
+			tcp_stats.ooo_drops++;
+			return;
+		}
+
+		memcpy(buf, data, len);
+	}
+
+	s = &c->ooo[i];
+	memmove(s + 1, s, (c->ooo_num - i) * sizeof(*s));
+
+	s->data = buf;
+	s->seq = seq;
+	s->len = len;
+	s->fin = fin;
+
+	c->ooo_num++;
+	tcp_stats.ooo_queued++;
+}
+
+/*
+ * Deliver queued segments which have become in order after a hole was filled.
+ * Return 1 if the peer's FIN has been reached.
+ */
+static int tcp_ooo_deliver(struct tcp_conn *c, struct tcb_cb_data *cbd)
+{
+	struct tcp_ooo_seg *s;
+	int offset, fin = 0;
+	u32 i;
+
+	for (i = 0; i < c->ooo_num; i++) {
+		s = &c->ooo[i];
+
+		offset = tcp_seq_sub(c->peer_seq, s->seq);
+		if (offset < 0)
+			break;
+
+		if ((u32) offset < s->len) {
+			c->peer_seq += s->len - offset;
+			tcp_stats.ooo_hits++;
+
+			cbd->status = TCP_CB_DATA_RCVD;
+			cbd->data = s->data + offset;
+			cbd->datalen = s->len - offset;
+			assert((size_t) c->cb > CONFIG_SYS_SDRAM_BASE);
+			c->cb(cbd);
+		}
+
+		if (s->fin && s->seq + s->len == c->peer_seq)
+			fin = 1;
+
+		free(s->data);
+	}
+
+	c->ooo_num -= i;
+	memmove(&c->ooo[0], &c->ooo[i], c->ooo_num * sizeof(c->ooo[0]));
+
+	return fin;
+}
+
 void receive_tcp(struct ip_hdr *ip, int len, struct ethernet_hdr *et)
 {
 	struct tcp_hdr *tcp;
@@ -330,6 +683,7 @@ void receive_tcp(struct ip_hdr *ip, int len, struct ethernet_hdr *et)
 	u8 *data;
 	u32 seq, ack, tmp;
 	u16 flags, chksum;
+	int dup_ack, fin;
 	struct tcb_cb_data cbd = {};
 
 	iphdr_len = (ip->ip_hl_v & 0x0f) * 4;
@@ -344,6 +698,8 @@ void receive_tcp(struct ip_hdr *ip, int len, struct ethernet_hdr *et)
 		return;
 	}
 
+	tcp_stats.segs_in++;
+
 	flags = ntohs(tcp->flags);
 	tcphdr_len = ((flags >> TCP_HDR_LEN_SHIFT) & TCP_HDR_LEN_MASK) * 4;
 	if (tcphdr_len < sizeof(struct tcp_hdr)) {
@@ -429,6 +785,12 @@ void receive_tcp(struct ip_hdr *ip, int len, struct ethernet_hdr *et)
 		c->local_seq++;
 		c->local_seq_last = c->local_seq;
 		c->local_seq_acked = c->local_seq;
+		c->local_seq_max = c->local_seq;
+
+		/* Initial congestion window */
+		c->cwnd = TCP_INIT_CWND_SEGS * c->mss;
+		c->ssthresh = TCP_TX_SEGS_MAX * c->mss;
+		c->recover = c->local_seq;
 
 		cbd.status = TCP_CB_NEW_CONN;
 		assert((size_t) c->cb > CONFIG_SYS_SDRAM_BASE);
@@ -439,9 +801,16 @@ void receive_tcp(struct ip_hdr *ip, int len, struct ethernet_hdr *et)
 
 		/* If there is incoming data, fall through */
 	case ESTABLISHED:
-		/* Update window */
+		/*
+		 * An ACK without payload and window update is duplicated if
+		 * it does not acknowledge new data
+		 */
 		tmp = ntohs(tcp->wnd) << c->peer_ws;
-		if (tmp > c->mss && tmp > c->peer_wnd)
+		dup_ack = !data_size && tmp && tmp == c->peer_wnd &&
+			!(flags & (TCP_SYN | TCP_FIN));
+
+		/* Update window */
+		if (tmp)
 			c->zw_mode = 0;
 		c->peer_wnd = tmp;
 
@@ -467,27 +836,26 @@ void receive_tcp(struct ip_hdr *ip, int len, struct ethernet_hdr *et)
 		} else if (tcp_seq_sub(seq, c->peer_seq) > 0) {
 			/*
 			 * Incoming packet loss.
-			 * Discard the payload and send an ACK to request
+			 * Keep the payload for reassembly and send a
+			 * duplicated ACK immediately to request
 			 * retransmission.
 			 */
+			if (data_size || (flags & TCP_FIN))
+				tcp_ooo_queue(c, seq, data, data_size,
+					flags & TCP_FIN);
+
 			data_size = 0;
-			c->ack_flag++;
-		}
+			flags &= ~TCP_FIN;
 
-		if (tcp_seq_sub(ack, c->local_seq_acked) > 0) {
-			/* clear retransmission state */
-			c->rexmit_mode = 0;
-			c->rexmit_wait_ack = 0;
+			tcp_send_packet(c, TCP_ACK, c->local_seq, c->peer_seq,
+				NULL, 0);
+			tcp_stats.dup_acks_out++;
+		}
 
+		if (tcp_seq_sub(ack, c->local_seq_acked) > 0 &&
+			tcp_seq_sub(ack, c->local_seq_max) <= 0) {
 			/* The peer has ACKed new data */
-			c->local_seq_acked = ack;
-
-			if (tcp_seq_sub(ack, c->ack_calc_rtt) >= 0 &&
-				c->ack_calc_rtt) {
-				/* Calculate new RTO */
-				c->ack_calc_rtt = 0;
-				rtt_calc(c);
-			}
+			tcp_ack_update(c, ack);
 
 			if (tcp_seq_sub(c->local_seq_acked,
 				c->local_seq_last) == c->txlen) {
@@ -498,44 +866,43 @@ void receive_tcp(struct ip_hdr *ip, int len, struct ethernet_hdr *et)
 				assert((size_t) c->cb > CONFIG_SYS_SDRAM_BASE);
 				c->cb(&cbd);
 			}
-		} else {
-			/*
-			 * If the peer ACKed the data chunk we've already
-			 * fully sent, just ignore it
-			 */
-			if (tcp_seq_sub(ack, c->local_seq_last) < 0)
-				break;
-
-			/* Currently no more unACKed data */
-			if (c->local_seq == c->local_seq_acked)
-				goto check_new_data;
-
-			/*
-			 * Record the transmission position the peer required,
-			 * and enter the retransmission mode
-			 */
-			c->local_seq_acked = ack;
-			c->rexmit_mode = 1;
+		} else if (ack == c->local_seq_acked && c->seg_num && dup_ack) {
+			/* The peer may have lost a segment */
+			tcp_dup_ack(c);
 		}
 
-	check_new_data:
+		fin = flags & TCP_FIN;
+
 		if (data_size) {
 			/*
 			 * We have new data received
 			 * Increase the next expected peer SEQ number
-			 * Send an ACK to acknowledge the peer
+			 * The ACK is delayed until enough segments have
+			 * been received or the delayed ACK timer expires
 			 */
 			c->peer_seq += data_size;
-			c->ack_flag++;
+
+			if (!c->rcv_unacked++)
+				c->ts_delack = get_timer(0);
+
+			if (c->rcv_unacked >= TCP_DELACK_SEGS)
+				c->ack_flag++;
 
 			cbd.status = TCP_CB_DATA_RCVD;
 			cbd.data = data;
 			cbd.datalen = data_size;
 			assert((size_t) c->cb > CONFIG_SYS_SDRAM_BASE);
 			c->cb(&cbd);
+
+			if (c->ooo_num) {
+				/* A hole has been filled, ACK immediately */
+				if (tcp_ooo_deliver(c, &cbd))
+					fin = 1;
+				c->ack_flag++;
+			}
 		}
 
-		if (flags & TCP_FIN) {
+		if (fin) {
 			/* The peer is closing the connection */
 			c->status = CLOSE_WAIT;
 			cbd.status = TCP_CB_REMOTE_CLOSING;
@@ -586,19 +953,6 @@ void receive_tcp(struct ip_hdr *ip, int len, struct ethernet_hdr *et)
 	}
 }
 
-static void tcp_rexmit_init(struct tcp_conn *c)
-{
-	c->ts_rexmit = get_timer(0);
-	c->ts = get_timer(0);
-	c->num_rexmit = 0;
-}
-
-static void tcp_rexmit_reset(struct tcp_conn *c)
-{
-	c->ts = get_timer(0);
-	c->num_rexmit++;
-}
-
 static int tcp_rexmit_check(struct tcp_conn *c, struct tcb_cb_data *cbd)
 {
 	ulong curts, timeout;
@@ -647,11 +1001,6 @@ static int tcp_rexmit_check(struct tcp_conn *c, struct tcb_cb_data *cbd)
 
 static void tcp_conn_check(struct tcp_conn *c)
 {
-	const u8 *data = NULL;
-	u32 datalen = 0;
-	u8 flags = TCP_ACK;
-	u32 sendseq;
-	u32 datalen_sent, datalen_acked;
 	u8 opt[8];
 	struct tcb_cb_data cbd = {};
 
@@ -670,7 +1019,7 @@ static void tcp_conn_check(struct tcp_conn *c)
 		case -1:
 			return;
 		case 1:
-			tcp_set_mss_opt(opt, c->mss);
+			tcp_set_mss_opt(opt, c);
 			tcp_send_packet_opt(c, TCP_SYN | TCP_ACK,
 				c->local_seq, c->peer_seq + 1,
 				opt, sizeof(opt), NULL, 0);
@@ -679,124 +1028,48 @@ static void tcp_conn_check(struct tcp_conn *c)
 
 		break;
 	case ESTABLISHED:
-		sendseq = c->local_seq;
-
-		datalen_sent = tcp_seq_sub(c->local_seq, c->local_seq_last);
-		datalen_acked =
-			tcp_seq_sub(c->local_seq_acked, c->local_seq_last);
-
-		if (!c->rexmit_mode) {
-			if (c->txlen > datalen_sent) {
-				/* There is still data to be sent */
-				data = c->tx + datalen_sent;
-				datalen = min(c->txlen - datalen_sent,
-					(u32) c->mss);
-
-				if (datalen >= c->peer_wnd) {
-					/* The peer may be zero-window */
-					if (!c->zw_mode)
-						tcp_rexmit_init(c);
-					/* Enter zero-window mode */
-					c->zw_mode = 1;
-					/* And send no data */
-					datalen = 0;
-				} else {
-					c->local_seq += datalen;
-					c->peer_wnd -= datalen;
-					c->ack_flag++;
-					if (datalen == c->txlen - datalen_sent)
-						flags |= TCP_PSH;
-					tcp_rexmit_init(c);
-				}
-			} else if (c->txlen > datalen_acked) {
-				/* There is data to be ACKed */
-				switch (tcp_rexmit_check(c, &cbd)) {
-				case -1:
-					return;
-				case 1:
-					/*
-					 * Timed out waiting for ACK, entering
-					 * retransmission mode
-					 */
-					c->rexmit_mode = 1;
-					c->rexmit_wait_ack = 0;
-				}
-			}
-		}
-
-		if (c->rexmit_mode) {
-			if (c->rexmit_wait_ack) {
-				switch (tcp_rexmit_check(c, &cbd)) {
-				case -1:
-					return;
-				case 1:
-					/*
-					 * Timed out waiting for ACK of
-					 * retransmitted segment, start for
-					 * the next trial
-					 */
-					c->rexmit_wait_ack = 0;
-				}
-			}
-
-			if (!c->rexmit_wait_ack) {
-				sendseq = c->local_seq_acked;
-
-				if (!c->zw_mode) {
-					/*
-					 * Send data if not in zero-window mode
-					 */
-					data = c->tx + datalen_acked;
-					datalen = min(c->txlen - datalen_acked,
-						(u32) c->mss);
-					c->ack_flag++;
-					c->rexmit_wait_ack = 1;
-					tcp_rexmit_reset(c);
-				}
-
-				if (get_timer(c->ts_rtt) > TCP_RTT_INTERVAL) {
-					/* Start calculating RTO */
-					c->ack_calc_rtt = c->local_seq_acked +
-						datalen;
-					c->ts_rtt = get_timer(0);
-				}
+		if (c->seg_num) {
+			/* There is data to be ACKed */
+			switch (tcp_rexmit_check(c, &cbd)) {
+			case -1:
+				return;
+			case 1:
+				/* Timed out waiting for ACK */
+				tcp_rexmit_timeout(c);
 			}
-		}
-
-		if (!c->peer_wnd || c->zw_mode) {
+		} else if (!c->peer_wnd && c->tx &&
+			c->txlen > tcp_seq_sub(c->local_seq, c->local_seq_last)) {
 			if (!c->zw_mode) {
 				/* Enter zero-window mode */
 				c->zw_mode = 1;
 				tcp_rexmit_init(c);
-			}
-
-			if (c->txlen > datalen_sent) {
+			} else {
 				/* Doing zero window probing */
 				switch (tcp_rexmit_check(c, &cbd)) {
 				case -1:
 					return;
 				case 1:
-					/*
-					 * If we have data unsend or unacked,
-					 * send one byte to probe
-					 */
-					datalen = 1;
-					sendseq = c->local_seq_acked;
-					data = c->tx + datalen_acked;
-					if (c->local_seq == c->local_seq_acked)
-						c->local_seq += datalen;
-					c->ack_flag++;
+					/* Send one byte to probe */
 					tcp_rexmit_reset(c);
+					tcp_send_new_seg(c, 1);
 				}
 			}
 		}
 
-		if (c->ack_flag) {
-			c->ack_flag = 0;
-			tcp_send_packet(c, flags, sendseq, c->peer_seq,
-				data, datalen);
+		/* Send as much data as the window allows */
+		tcp_send_window(c);
+
+		if (!c->ack_flag && c->rcv_unacked &&
+			get_timer(c->ts_delack) >= TCP_DELACK_TIMEOUT) {
+			/* Delayed ACK timer expired */
+			c->ack_flag++;
+			tcp_stats.delayed_acks++;
 		}
 
+		if (c->ack_flag)
+			tcp_send_packet(c, TCP_ACK, c->local_seq, c->peer_seq,
+				NULL, 0);
+
 		if (c->close_flag) {
 			if (!c->tx || !c->txlen) {
 				/*
@@ -902,7 +1175,11 @@ static int tcp_send_packet_opt(struct tcp_conn *c, u16 flags, u32 seq, u32 ack,
 		TCP_HDR_LEN_SHIFT) | (flags & TCP_FLAG_MASK));
 	memcpy(&tcp->seq, &seq, 4);
 	memcpy(&tcp->ack, &ack, 4);
-	tcp->wnd = htons(c->mss);
+	/* The window field of SYN packets is never scaled */
+	if (flags & TCP_SYN)
+		tcp->wnd = htons(min(TCP_RCV_WND, 0xffff));
+	else
+		tcp->wnd = htons(tcp_rcv_wnd(c) >> c->rcv_ws);
 	/* avoid compiler's optimization leading to an unaligned access */
 	memset(&tcp->urg, 0, sizeof(tcp->urg));
 	tcp->chksum = 0;
@@ -921,6 +1198,17 @@ static int tcp_send_packet_opt(struct tcp_conn *c, u16 flags, u32 seq, u32 ack,
 
 	pkt_hdr_size = eth_hdr_size + IP_HDR_SIZE + TCP_HDR_SIZE + opt_size;
 
+	/* Every packet with the ACK bit acknowledges all received data */
+	if (flags & TCP_ACK) {
+		c->ack_flag = 0;
+		c->rcv_unacked = 0;
+
+		if (!payload_len && !(flags & (TCP_SYN | TCP_FIN | TCP_RST)))
+			tcp_stats.acks_out++;
+	}
+
+	tcp_stats.segs_out++;
+
 	/* if MAC address was not discovered yet, do an ARP request */
 	if (memcmp(c->ethaddr, net_null_ethaddr, 6) == 0) {
 		/* save the ip and eth addr for the packet to send after arp */
@@ -1041,3 +1329,13 @@ int tcp_conn_is_alive(const void *conn)
 
 	return c->status == ESTABLISHED;
 }
+
+void tcp_get_stats(struct tcp_stats *stats)
+{
+	memcpy(stats, &tcp_stats, sizeof(tcp_stats));
+}
+
+void tcp_reset_stats(void)
+{
+	memset(&tcp_stats, 0, sizeof(tcp_stats));
+}
@@ -52,12 +52,25 @@ struct tcp_hdr {
 #define TCP_RTT_K		4
 #define TCP_RTT_ALPHA		3
 #define TCP_RTT_BETA		2
-#define TCP_RTT_INTERVAL	3000
 
 /* TCP retransmission options */
 #define TCP_REXMIT_MAX_SEG_DELAY	60000
 #define TCP_REXMIT_MAX_CONN_DELAY	300000
 
+/* TCP sliding window / congestion control options */
+#define TCP_TX_SEGS_MAX		64
+#define TCP_INIT_CWND_SEGS	10
+#define TCP_DUPACK_THRESH	3
+
+/* TCP receive window / reassembly options */
+#define TCP_RCV_WND		(96 << 10)
+#define TCP_RCV_WS		1
+#define TCP_OOO_SEGS_MAX	64
+
+/* TCP delayed ACK options */
+#define TCP_DELACK_SEGS		2
+#define TCP_DELACK_TIMEOUT	40
+
 /* TCP state */
 enum tcp_state {
 	INVALID_TCP_STATE = 0,
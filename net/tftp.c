@@ -103,6 +103,7 @@ static int	tftp_put_final_block_sent;
 #define STATE_OACK	5
 #define STATE_RECV_WRQ	6
 #define STATE_SEND_WRQ	7
+#define STATE_SEND_OACK	8
 
 /* default TFTP block size */
 #define TFTP_BLOCK_SIZE		512
@@ -134,6 +135,19 @@ static char tftp_filename[MAX_LEN];
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = TFTP_MTU_BLOCKSIZE;
 
+/* RFC 7440: number of blocks to be received before sending an ACK */
+static unsigned short tftp_window_size = 1;
+static unsigned short tftp_window_size_option = CONFIG_TFTP_WINDOWSIZE;
+/* block number which completes the current window */
+static ulong	tftp_next_ack;
+/* last in-order block we have sent an ACK for because of a gap */
+static ulong	tftp_last_nack;
+#ifdef CONFIG_CMD_TFTPSRV
+/* options of a write request to be acknowledged by an OACK */
+static int	tftp_oack_block_size;
+static int	tftp_oack_window_size;
+#endif
+
 #ifdef CONFIG_MCAST_TFTP
 #include <malloc.h>
 #define MTFTP_BITMAPSIZE	0x1000
@@ -211,6 +225,9 @@ static void new_transfer(void)
 	tftp_prev_block = 0;
 	tftp_block_wrap = 0;
 	tftp_block_wrap_offset = 0;
+	tftp_next_ack = tftp_window_size;
+	/* Not a valid block number */
+	tftp_last_nack = TFTP_SEQUENCE_SIZE;
 #ifdef CONFIG_CMD_TFTPPUT
 	tftp_put_final_block_sent = 0;
 #endif
@@ -372,6 +389,10 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+		/* try for more blocks per ACK, only when reading */
+		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_window_size_option, 0);
 #ifdef CONFIG_MCAST_TFTP
 		/* Check all preconditions before even trying the option */
 		if (!tftp_mcast_disabled) {
@@ -417,6 +438,22 @@ static void tftp_send(void)
 		len = pkt - xp;
 		break;
 
+#ifdef CONFIG_CMD_TFTPSRV
+	case STATE_SEND_OACK:
+		xp = pkt;
+		s = (ushort *)pkt;
+		*s++ = htons(TFTP_OACK);
+		pkt = (uchar *)s;
+		if (tftp_oack_block_size)
+			pkt += sprintf((char *)pkt, "blksize%c%d%c",
+					0, tftp_block_size, 0);
+		if (tftp_oack_window_size)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_window_size, 0);
+		len = pkt - xp;
+		break;
+#endif
+
 	case STATE_TOO_LARGE:
 		xp = pkt;
 		s = (ushort *)pkt;
@@ -457,6 +494,55 @@ static void icmp_handler(unsigned type, unsigned code, unsigned dest,
 }
 #endif
 
+#ifdef CONFIG_CMD_TFTPSRV
+/*
+ * Parse the options of a write request. Return 1 if any option has been
+ * accepted, which must be acknowledged by an OACK instead of ACK(0).
+ */
+static int tftp_parse_wrq_options(const char *pkt, unsigned len)
+{
+	const char *end = pkt + len;
+	const char *opt, *val;
+	ulong n;
+
+	tftp_oack_block_size = 0;
+	tftp_oack_window_size = 0;
+
+	/* Skip the file name and the transfer mode */
+	pkt += strnlen(pkt, end - pkt) + 1;
+	if (pkt < end)
+		pkt += strnlen(pkt, end - pkt) + 1;
+
+	while (pkt < end) {
+		opt = pkt;
+		pkt += strnlen(pkt, end - pkt) + 1;
+		if (pkt >= end)
+			break;
+
+		val = pkt;
+		pkt += strnlen(pkt, end - pkt) + 1;
+		if (pkt > end)
+			break;
+
+		n = simple_strtoul(val, NULL, 10);
+
+		if (!strcasecmp(opt, "blksize") && n >= 8) {
+			tftp_block_size = min(n, (ulong)tftp_block_size_option);
+			tftp_oack_block_size = 1;
+			debug("Blocksize req: %s, %d\n", val, tftp_block_size);
+		} else if (!strcasecmp(opt, "windowsize") && n >= 1) {
+			tftp_window_size = min(n,
+					       (ulong)tftp_window_size_option);
+			tftp_oack_window_size = 1;
+			debug("Windowsize req: %s, %d\n", val,
+			      tftp_window_size);
+		}
+	}
+
+	return tftp_oack_block_size || tftp_oack_window_size;
+}
+#endif
+
 static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			 unsigned src, unsigned len)
 {
@@ -517,8 +603,10 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		tftp_remote_ip = sip;
 		tftp_remote_port = src;
 		tftp_our_port = 1024 + (get_timer(0) % 3072);
+		if (tftp_parse_wrq_options((char *)pkt, len))
+			tftp_state = STATE_SEND_OACK;
 		new_transfer();
-		tftp_send(); /* Send ACK(0) */
+		tftp_send(); /* Send OACK or ACK(0) */
 		break;
 #endif
 
@@ -548,9 +636,22 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				      (char *)pkt + i + 6, tftp_tsize);
 			}
 #endif
+			if (strcmp((char *)pkt + i, "windowsize") == 0 &&
+			    i + 11 < len) {
+				tftp_window_size = (unsigned short)
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				if (!tftp_window_size)
+					tftp_window_size = 1;
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt + i + 11, tftp_window_size);
+			}
 		}
 #ifdef CONFIG_MCAST_TFTP
 		parse_multicast_oack((char *)pkt, len - 1);
+		/* Multicast transfers are never windowed */
+		if (tftp_mcast_active)
+			tftp_window_size = 1;
 		if ((tftp_mcast_active) && (!tftp_mcast_master_client))
 			tftp_state = STATE_DATA;	/* passive.. */
 		else
@@ -570,13 +671,25 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		len -= 2;
 		tftp_cur_block = ntohs(*(__be16 *)pkt);
 
-		update_block_number();
-
 		if (tftp_state == STATE_SEND_RRQ)
 			debug("Server did not acknowledge timeout option!\n");
 
 		if (tftp_state == STATE_SEND_RRQ || tftp_state == STATE_OACK ||
-		    tftp_state == STATE_RECV_WRQ) {
+		    tftp_state == STATE_RECV_WRQ ||
+		    tftp_state == STATE_SEND_OACK) {
+			if (tftp_window_size > 1 && tftp_cur_block != 1) {
+				/*
+				 * The first block of the window is lost, ask
+				 * for the whole window again
+				 */
+				tftp_cur_block = 0;
+				if (tftp_last_nack != 0) {
+					tftp_last_nack = 0;
+					tftp_send();
+				}
+				break;
+			}
+
 			/* first block received */
 			tftp_state = STATE_DATA;
 			tftp_remote_port = src;
@@ -597,11 +710,33 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			}
 		}
 
+		if (tftp_window_size > 1 &&
+		    tftp_cur_block != ((tftp_prev_block + 1) & 0xffff)) {
+			/*
+			 * Out of window: a block has been lost, or the remote
+			 * is sending the window again. ACK the last block we
+			 * received in order, once, so that the remote goes
+			 * back to the next block we need.
+			 */
+			debug("Unexpected block %lu, expected %lu\n",
+			      tftp_cur_block, (tftp_prev_block + 1) & 0xffff);
+			tftp_cur_block = tftp_prev_block;
+			if (tftp_last_nack != tftp_prev_block) {
+				tftp_last_nack = tftp_prev_block;
+				tftp_next_ack = (tftp_prev_block +
+						 tftp_window_size) & 0xffff;
+				tftp_send();
+			}
+			break;
+		}
+
 		if (tftp_cur_block == tftp_prev_block) {
 			/* Same block again; ignore it. */
 			break;
 		}
 
+		update_block_number();
+
 		tftp_prev_block = tftp_cur_block;
 		timeout_count_max = tftp_timeout_count_max;
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
@@ -638,7 +773,16 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			}
 		}
 #endif
-		tftp_send();
+		/*
+		 * With a window, only the last block of the window and the
+		 * last block of the file are acknowledged
+		 */
+		if (tftp_window_size <= 1 || tftp_cur_block == tftp_next_ack ||
+		    len < tftp_block_size) {
+			tftp_next_ack = (tftp_cur_block + tftp_window_size) &
+					0xffff;
+			tftp_send();
+		}
 
 #ifdef CONFIG_MCAST_TFTP
 		if (tftp_mcast_active) {
@@ -690,12 +834,41 @@ static void tftp_timeout_handler(void)
 	} else {
 		puts("T ");
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+		if (tftp_state == STATE_DATA && !tftp_put_active) {
+			/*
+			 * The ACK sent again makes the remote restart the
+			 * window after the current block: expect the end of
+			 * that window, and NACK again if a block gets lost.
+			 */
+			tftp_next_ack = (tftp_cur_block + tftp_window_size) &
+					0xffff;
+			tftp_last_nack = TFTP_SEQUENCE_SIZE;
+		}
 		if (tftp_state != STATE_RECV_WRQ)
 			tftp_send();
 	}
 }
 
 
+/* Allow the user to choose the TFTP window size */
+static void tftp_window_size_init(void)
+{
+#if CONFIG_NET_TFTP_VARS
+	char *ep;
+
+	ep = env_get("tftpwindowsize");
+	if (ep != NULL)
+		tftp_window_size_option = simple_strtoul(ep, NULL, 10);
+#endif
+
+	if (!tftp_window_size_option)
+		tftp_window_size_option = 1;
+
+	/* Lock-step transfer until the remote accepts the option */
+	tftp_window_size = 1;
+	tftp_last_nack = TFTP_SEQUENCE_SIZE;
+}
+
 void tftp_start(enum proto_t protocol)
 {
 #if CONFIG_NET_TFTP_VARS
@@ -730,9 +903,10 @@ void tftp_start(enum proto_t protocol)
 		tftp_timeout_count_max = 0;
 	}
 #endif
+	tftp_window_size_init();
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (!net_parse_bootfile(&tftp_remote_ip, tftp_filename, MAX_LEN)) {
@@ -855,6 +1029,7 @@ void tftp_start_server(void)
 
 	/* Revert tftp_block_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size_init();
 	tftp_cur_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
 
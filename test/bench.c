@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Helpers shared by the unit tests which measure throughput
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <os.h>
+#include <test/bench.h>
+
+void ut_fill_pattern(u8 *buf, size_t len, u8 seed)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = seed + i * 7 + (i >> 8);
+}
+
+void ut_bench_report_bytes(const char *name, ulong start, u64 bytes)
+{
+	ulong elapsed = max(timer_get_us() - start, 1UL);
+
+	printf("%-24s %8lu us %8llu KiB/s\n", name, elapsed,
+	       bytes * 1000000 / elapsed / 1024);
+}
+
+void ut_bench_report(const char *name, ulong start)
+{
+	ut_bench_report_bytes(name, start, (u64)UT_BENCH_SIZE * UT_BENCH_LOOPS);
+}
+
+#ifdef CONFIG_SANDBOX
+void *ut_bench_read_file(const char *fname, ulong *sizep)
+{
+	loff_t size;
+	void *buf;
+	int fd;
+
+	if (os_get_filesize(fname, &size))
+		return NULL;
+
+	buf = malloc(size);
+	if (!buf)
+		return NULL;
+
+	fd = os_open(fname, OS_O_RDONLY);
+	if (fd < 0 || os_read(fd, buf, size) != size) {
+		if (fd >= 0)
+			os_close(fd);
+		free(buf);
+		return NULL;
+	}
+
+	os_close(fd);
+	*sizep = size;
+
+	return buf;
+}
+#endif
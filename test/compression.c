@@ -18,6 +18,7 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <test/bench.h>
 #include <test/compression.h>
 #include <test/suites.h>
 #include <test/ut.h>
@@ -532,6 +533,64 @@ static int compression_test_bootm_none(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_bootm_none, 0);
 
+/*
+ * Decode time of the SPL payload with each codec supported by SPL. The files
+ * are read from the current directory and generated with:
+ *
+ *   make u-boot.bin.lzma u-boot.bin.lz4
+ *
+ * Run from a MT7621 build directory to compare the codecs on its u-boot.bin.
+ */
+static int compression_test_bench(struct unit_test_state *uts)
+{
+	static const struct {
+		const char *fname;
+		mutate_func uncompress;
+	} codecs[] = {
+		{ "u-boot.bin.lzma", uncompress_using_lzma },
+		{ "u-boot.bin.lz4", uncompress_using_lz4 },
+	};
+	void *orig, *in, *out;
+	ulong orig_size, in_size, out_size, start;
+	int i, loop;
+
+	orig = ut_bench_read_file("u-boot.bin", &orig_size);
+	if (!orig) {
+		printf(" u-boot.bin not found, skipping\n");
+		return 0;
+	}
+
+	out = malloc(orig_size);
+	ut_assertnonnull(out);
+
+	for (i = 0; i < ARRAY_SIZE(codecs); i++) {
+		in = ut_bench_read_file(codecs[i].fname, &in_size);
+		if (!in) {
+			printf(" %s not found, skipping\n", codecs[i].fname);
+			continue;
+		}
+
+		start = timer_get_us();
+		for (loop = 0; loop < UT_BENCH_LOOPS; loop++) {
+			ut_assertok(codecs[i].uncompress(uts, in, in_size, out,
+							 orig_size, &out_size));
+		}
+		ut_bench_report_bytes(codecs[i].fname, start,
+				      (u64)out_size * UT_BENCH_LOOPS);
+
+		ut_asserteq(orig_size, out_size);
+		ut_asserteq(0, memcmp(orig, out, orig_size));
+
+		free(in);
+	}
+
+	free(out);
+	free(orig);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_bench, 0);
+
 int do_ut_compression(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	struct unit_test *tests = ll_entry_start(struct unit_test,
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Tests of the table driven CRC32 against a bitwise reference, with all the
+ * alignments of the input, and a benchmark of its throughput.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <test/bench.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/crc.h>
+
+#define CRC32_TEST(_name, _flags)	UNIT_TEST(_name, _flags, crc32_test)
+
+/* Lengths are tested up to 4 iterations of slice-by-8, plus bytes */
+#define CRC32_TEST_MAX_LEN	40
+#define CRC32_TEST_ALIGN	8
+
+/* Reference implementation, not using the tables under test */
+static u32 crc32_test_ref(u32 crc, const u8 *buf, size_t len)
+{
+	int i;
+
+	while (len--) {
+		crc ^= *buf++;
+		for (i = 0; i < 8; i++)
+			crc = (crc >> 1) ^ (crc & 1 ? 0xedb88320 : 0);
+	}
+
+	return crc;
+}
+
+static int crc32_test_vectors(struct unit_test_state *uts)
+{
+	const u8 *check = (const u8 *)"123456789";
+
+	ut_asserteq(0, crc32(0, check, 0));
+	ut_asserteq(0xcbf43926, crc32(0, check, 9));
+	ut_asserteq(0x2dfd2d88, crc32_no_comp(0, check, 9));
+
+	return 0;
+}
+CRC32_TEST(crc32_test_vectors, 0);
+
+static int crc32_test_align(struct unit_test_state *uts)
+{
+	u8 buf[CRC32_TEST_MAX_LEN + CRC32_TEST_ALIGN];
+	int align, len;
+	u8 *p;
+
+	ut_fill_pattern(buf, sizeof(buf), 1);
+
+	for (align = 0; align < CRC32_TEST_ALIGN; align++) {
+		for (len = 0; len <= CRC32_TEST_MAX_LEN; len++) {
+			p = buf + align;
+
+			ut_asserteq(crc32_test_ref(0x12345678, p, len),
+				    crc32_no_comp(0x12345678, p, len));
+			ut_asserteq(~crc32_test_ref(~0x12345678, p, len),
+				    crc32(0x12345678, p, len));
+		}
+	}
+
+	return 0;
+}
+CRC32_TEST(crc32_test_align, 0);
+
+/* Computing the CRC in two parts must give the same result */
+static int crc32_test_split(struct unit_test_state *uts)
+{
+	u8 buf[CRC32_TEST_MAX_LEN];
+	u32 crc;
+	int i;
+
+	ut_fill_pattern(buf, sizeof(buf), 3);
+
+	for (i = 0; i <= sizeof(buf); i++) {
+		crc = crc32(0, buf, i);
+		crc = crc32(crc, buf + i, sizeof(buf) - i);
+		ut_asserteq(crc32(0, buf, sizeof(buf)), crc);
+	}
+
+	return 0;
+}
+CRC32_TEST(crc32_test_split, 0);
+
+/* Throughput of crc32() */
+static int crc32_test_bench(struct unit_test_state *uts)
+{
+	ulong start;
+	u32 crc = 0;
+	u8 *buf;
+	int i;
+
+	buf = malloc(UT_BENCH_SIZE);
+	ut_assertnonnull(buf);
+
+	ut_fill_pattern(buf, UT_BENCH_SIZE, 5);
+
+	start = timer_get_us();
+	for (i = 0; i < UT_BENCH_LOOPS; i++)
+		crc = crc32(crc, buf, UT_BENCH_SIZE);
+	ut_bench_report("crc32", start);
+
+	free(buf);
+
+	return 0;
+}
+CRC32_TEST(crc32_test_bench, 0);
+
+int do_ut_crc32(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test, crc32_test);
+	const int n_ents = ll_entry_count(struct unit_test, crc32_test);
+
+	return cmd_ut_category("crc32", tests, n_ents, argc, argv);
+}
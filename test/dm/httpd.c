@@ -0,0 +1,391 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Sandbox tests for the multipart/form-data parser of the HTTP server. The
+ * same request is sent by the TCP loopback peer in segments of every size up
+ * to HTTPD_TEST_CHUNK_MAX, and the form values and the file passed to the
+ * upload handler are checked against what was sent.
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <malloc.h>
+#include <net.h>
+#include <net/httpd.h>
+#include <dm/test.h>
+#include <test/ut.h>
+#include <u-boot/md5.h>
+
+#include "tcp_peer.h"
+
+#define HTTPD_TEST_URI		"/upload"
+#define HTTPD_TEST_BOUNDARY_HEAD "----UBootTestBoundary"
+#define HTTPD_TEST_BOUNDARY	HTTPD_TEST_BOUNDARY_HEAD "7MA4YWxk"
+#define HTTPD_TEST_DELIM	"\r\n--" HTTPD_TEST_BOUNDARY
+#define HTTPD_TEST_FILE_SIZE	3000
+#define HTTPD_TEST_HDR_MAX	256
+#define HTTPD_TEST_REQ_SIZE	(HTTPD_TEST_FILE_SIZE + 1024)
+#define HTTPD_TEST_CHUNK_MAX	64
+#define HTTPD_TEST_TIMEOUT	10000
+
+/* Value data which starts like the delimiter but does not match it */
+#define HTTPD_TEST_COMMENT	"a\r\r\n-b\r\n--c\r\n--" \
+				HTTPD_TEST_BOUNDARY_HEAD "7MA4YWxz\r"
+
+/* Delimiter prefixes put into the file data */
+static const char * const httpd_test_traps[] = {
+	"\r",
+	"\r\n",
+	"\r\n-",
+	"\r\n--",
+	"\r\n--" HTTPD_TEST_BOUNDARY_HEAD,
+	"\r\n--" HTTPD_TEST_BOUNDARY_HEAD "7MA4YWx",
+	"\r\r\n\r\n--" HTTPD_TEST_BOUNDARY_HEAD "7MA4\r\n--",
+};
+
+/* The file also ends with a delimiter prefix */
+#define HTTPD_TEST_FILE_TAIL	"\r\n--" HTTPD_TEST_BOUNDARY_HEAD "7MA4YW"
+
+struct httpd_test_result {
+	/* Upload handler */
+	u32 starts;
+	u32 ends;
+	u32 aborts;
+	u32 rcvd;
+	int mismatch;
+	u8 md5[16];
+
+	/* URI handler */
+	u32 requests;
+	u32 count;
+	int comment_ok;
+	int file_ok;
+	int closed;
+
+	/* Response received by the peer */
+	char resp[256];
+	u32 resplen;
+};
+
+static struct httpd_test_result res;
+static u8 *httpd_test_file;
+
+static int httpd_test_upload_cb(enum httpd_upload_status status,
+				struct httpd_request *request,
+				struct httpd_form_value *value,
+				const void *data, size_t size)
+{
+	switch (status) {
+	case HTTP_UPLOAD_START:
+		if (strcmp(value->name, "firmware") ||
+		    strcmp(value->filename, "fw.bin"))
+			res.mismatch = 1;
+		res.starts++;
+		break;
+	case HTTP_UPLOAD_DATA:
+		if (res.rcvd + size > HTTPD_TEST_FILE_SIZE ||
+		    memcmp(httpd_test_file + res.rcvd, data, size))
+			res.mismatch = 1;
+		res.rcvd += size;
+		break;
+	case HTTP_UPLOAD_END:
+		memcpy(res.md5, value->md5, sizeof(res.md5));
+		res.ends++;
+		break;
+	case HTTP_UPLOAD_ABORT:
+		res.aborts++;
+		break;
+	}
+
+	return 0;
+}
+
+static void httpd_test_uri_cb(enum httpd_uri_handler_status status,
+			      struct httpd_request *request,
+			      struct httpd_response *response)
+{
+	struct httpd_form_value *val;
+
+	if (status == HTTP_CB_CLOSED) {
+		res.closed = 1;
+		return;
+	}
+
+	if (status != HTTP_CB_NEW) {
+		response->status = HTTP_RESP_NONE;
+		return;
+	}
+
+	res.requests++;
+	res.count = request->form.count;
+
+	val = httpd_request_find_value(request, "comment");
+	if (val && !val->filename &&
+	    val->size == sizeof(HTTPD_TEST_COMMENT) - 1 &&
+	    !memcmp(val->data, HTTPD_TEST_COMMENT, val->size))
+		res.comment_ok = 1;
+
+	val = httpd_request_find_value(request, "firmware");
+	if (val && val->filename && val->size == HTTPD_TEST_FILE_SIZE)
+		res.file_ok = 1;
+
+	response->status = HTTP_RESP_STD;
+	response->data = "OK";
+	response->size = 2;
+	response->info.code = 200;
+	response->info.connection_close = 1;
+	response->info.content_type = "text/plain";
+}
+
+static void httpd_test_peer_rx(const u8 *data, u32 len)
+{
+	len = min(len, (u32)sizeof(res.resp) - res.resplen - 1);
+	memcpy(res.resp + res.resplen, data, len);
+	res.resplen += len;
+	res.resp[res.resplen] = 0;
+}
+
+/*
+ * Build a request with a preamble, a value, the file and a part without
+ * headers, which must be ignored. The body is finished with end.
+ */
+static u32 httpd_test_make_req(char *req, const char *end, int truncate)
+{
+	char hdr[HTTPD_TEST_HDR_MAX], *body, *p;
+	u32 size, hdrlen;
+
+	body = req + HTTPD_TEST_HDR_MAX;
+	p = body;
+
+	p += sprintf(p, "preamble" HTTPD_TEST_DELIM "\r\n"
+		     "Content-Disposition: form-data; name=\"comment\"\r\n"
+		     "\r\n" HTTPD_TEST_COMMENT HTTPD_TEST_DELIM "\r\n"
+		     "Content-Disposition: form-data; name=\"firmware\"; "
+		     "filename=\"fw.bin\"\r\n"
+		     "Content-Type: application/octet-stream\r\n"
+		     "\r\n");
+
+	memcpy(p, httpd_test_file, HTTPD_TEST_FILE_SIZE);
+	p += HTTPD_TEST_FILE_SIZE;
+
+	/* Content-Length may stop right after the file */
+	size = p - body;
+
+	/* Data of the part without headers looks like a header block */
+	p += sprintf(p, HTTPD_TEST_DELIM "\r\n"
+		     "\r\n"
+		     "no\r\n\r\nheaders%s", end);
+
+	if (!truncate)
+		size = p - body;
+
+	hdrlen = snprintf(hdr, sizeof(hdr),
+			  "POST " HTTPD_TEST_URI " HTTP/1.1\r\n"
+			  "Host: 1.1.2.1\r\n"
+			  "Content-Type: multipart/form-data; boundary="
+			  HTTPD_TEST_BOUNDARY "\r\n"
+			  "Content-Length: %u\r\n"
+			  "\r\n", size);
+
+	memcpy(req, hdr, hdrlen);
+	memmove(req + hdrlen, body, size);
+
+	return hdrlen + size;
+}
+
+/* Send the request in segments of chunk bytes and wait for the response */
+static int httpd_test_send(struct unit_test_state *uts, const char *req,
+			   u32 size, u32 chunk, u16 port)
+{
+	ulong start;
+	u32 i, len;
+
+	memset(&res, 0, sizeof(res));
+	tcp_test_peer_reset(port);
+	tcp_peer.rx = httpd_test_peer_rx;
+
+	tcp_test_peer_send(TCP_SYN, 0);
+	tcp_test_peer_flush();
+
+	for (i = 0; i < size; i += len) {
+		len = min(chunk, size - i);
+		tcp_test_peer_send_data(TCP_ACK | TCP_PSH, tcp_peer.seq,
+					tcp_peer.ack, req + i, len);
+		tcp_peer.seq += len;
+
+		tcp_periodic_check();
+		tcp_test_peer_flush();
+	}
+
+	start = get_timer(0);
+	while (!tcp_peer.fin && get_timer(start) < HTTPD_TEST_TIMEOUT) {
+		tcp_periodic_check();
+		tcp_test_peer_flush();
+	}
+
+	/* Let the server leave TIME_WAIT and release the session */
+	tcp_periodic_check();
+
+	ut_asserteq(1, tcp_peer.fin);
+
+	return 0;
+}
+
+static int httpd_test_setup(struct unit_test_state *uts, char **req)
+{
+	struct httpd_instance *inst;
+	u32 i, pos;
+
+	httpd_test_file = malloc(HTTPD_TEST_FILE_SIZE);
+	ut_assertnonnull(httpd_test_file);
+
+	*req = malloc(HTTPD_TEST_REQ_SIZE);
+	ut_assertnonnull(*req);
+
+	for (i = 0; i < HTTPD_TEST_FILE_SIZE; i++)
+		httpd_test_file[i] = (i * 7) + (i >> 8);
+
+	for (i = 0; i < ARRAY_SIZE(httpd_test_traps); i++) {
+		pos = 50 + i * 300;
+		memcpy(httpd_test_file + pos, httpd_test_traps[i],
+		       strlen(httpd_test_traps[i]));
+	}
+
+	pos = HTTPD_TEST_FILE_SIZE - (sizeof(HTTPD_TEST_FILE_TAIL) - 1);
+	memcpy(httpd_test_file + pos, HTTPD_TEST_FILE_TAIL,
+	       sizeof(HTTPD_TEST_FILE_TAIL) - 1);
+
+	/* The HTTP server listens by itself */
+	ut_assertok(tcp_test_peer_setup(uts, NULL));
+
+	inst = httpd_create_instance(TCP_TEST_PORT);
+	ut_assertnonnull(inst);
+	ut_assertok(httpd_register_uri_upload_handler(inst, HTTPD_TEST_URI,
+						      httpd_test_uri_cb,
+						      httpd_test_upload_cb,
+						      NULL));
+
+	return 0;
+}
+
+static void httpd_test_cleanup(char *req)
+{
+	httpd_free_instance_by_port(TCP_TEST_PORT);
+	tcp_test_peer_cleanup();
+	free(req);
+	free(httpd_test_file);
+}
+
+static int httpd_test_check_resp(struct unit_test_state *uts, u32 code)
+{
+	char status[16];
+
+	snprintf(status, sizeof(status), "HTTP/1.1 %u ", code);
+	ut_assert(!strncmp(res.resp, status, strlen(status)));
+
+	return 0;
+}
+
+/* Test that the request is parsed the same way for every segment size */
+static int dm_test_net_httpd_multipart(struct unit_test_state *uts)
+{
+	u32 size, chunk, port = TCP_TEST_PEER_PORT;
+	u8 md5sum[16];
+	char *req;
+
+	ut_assertok(httpd_test_setup(uts, &req));
+
+	md5(httpd_test_file, HTTPD_TEST_FILE_SIZE, md5sum);
+	size = httpd_test_make_req(req, HTTPD_TEST_DELIM "--\r\nepilogue", 0);
+
+	for (chunk = 1; chunk <= HTTPD_TEST_CHUNK_MAX + 1; chunk++) {
+		/* Finish with segments of the MSS */
+		ut_assertok(httpd_test_send(uts, req, size,
+					    chunk > HTTPD_TEST_CHUNK_MAX ?
+					    TCP_MSS : chunk, port++));
+
+		ut_assertok(httpd_test_check_resp(uts, 200));
+		ut_asserteq(1, res.requests);
+		ut_asserteq(1, res.closed);
+
+		/* The part without headers is not a form value */
+		ut_asserteq(2, res.count);
+		ut_asserteq(1, res.comment_ok);
+		ut_asserteq(1, res.file_ok);
+
+		ut_asserteq(1, res.starts);
+		ut_asserteq(1, res.ends);
+		ut_asserteq(0, res.aborts);
+		ut_asserteq(0, res.mismatch);
+		ut_asserteq(HTTPD_TEST_FILE_SIZE, res.rcvd);
+		ut_assert(!memcmp(md5sum, res.md5, sizeof(md5sum)));
+	}
+
+	httpd_test_cleanup(req);
+
+	return 0;
+}
+DM_TEST(dm_test_net_httpd_multipart, DM_TESTF_SCAN_FDT);
+
+/*
+ * Test that a body which ends before the closing delimiter aborts the upload,
+ * and that the request is still passed to the URI handler
+ */
+static int dm_test_net_httpd_truncated(struct unit_test_state *uts)
+{
+	u32 size, chunk, port = TCP_TEST_PEER_PORT;
+	char *req;
+
+	ut_assertok(httpd_test_setup(uts, &req));
+
+	size = httpd_test_make_req(req, HTTPD_TEST_DELIM "--\r\n", 1);
+
+	for (chunk = 1; chunk <= HTTPD_TEST_CHUNK_MAX; chunk++) {
+		ut_assertok(httpd_test_send(uts, req, size, chunk, port++));
+
+		ut_assertok(httpd_test_check_resp(uts, 200));
+		ut_asserteq(1, res.requests);
+
+		ut_asserteq(1, res.starts);
+		ut_asserteq(0, res.ends);
+		ut_asserteq(1, res.aborts);
+		ut_asserteq(0, res.mismatch);
+	}
+
+	httpd_test_cleanup(req);
+
+	return 0;
+}
+DM_TEST(dm_test_net_httpd_truncated, DM_TESTF_SCAN_FDT);
+
+/*
+ * Test that a delimiter followed by anything but CRLF or "--" is answered
+ * with 400, and that the request is not passed to the URI handler
+ */
+static int dm_test_net_httpd_bad_delim(struct unit_test_state *uts)
+{
+	u32 size, chunk, port = TCP_TEST_PEER_PORT;
+	char *req;
+
+	ut_assertok(httpd_test_setup(uts, &req));
+
+	size = httpd_test_make_req(req, HTTPD_TEST_DELIM "xx\r\n", 0);
+
+	for (chunk = 1; chunk <= HTTPD_TEST_CHUNK_MAX; chunk++) {
+		ut_assertok(httpd_test_send(uts, req, size, chunk, port++));
+
+		ut_assertok(httpd_test_check_resp(uts, 400));
+		ut_asserteq(0, res.requests);
+
+		/* The file has been completed by the delimiter */
+		ut_asserteq(1, res.starts);
+		ut_asserteq(1, res.ends);
+		ut_asserteq(0, res.aborts);
+		ut_asserteq(0, res.mismatch);
+		ut_asserteq(HTTPD_TEST_FILE_SIZE, res.rcvd);
+	}
+
+	httpd_test_cleanup(req);
+
+	return 0;
+}
+DM_TEST(dm_test_net_httpd_bad_delim, DM_TESTF_SCAN_FDT);
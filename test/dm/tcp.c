@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Sandbox tests for the TCP stack. The sandbox ethernet driver is used as a
+ * loopback wire, with a minimal TCP peer receiving the data sent by
+ * tcp_send_data() and measuring the throughput, or sending data to the stack
+ * out of order.
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <malloc.h>
+#include <net.h>
+#include <net/tcp.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+#include "tcp_peer.h"
+
+#define TCP_TEST_BUF_SIZE	(1 << 20)
+#define TCP_TEST_CHUNK_SIZE	(256 << 10)
+#define TCP_TEST_TIMEOUT	30000
+#define TCP_TEST_RX_SEGS	512
+
+struct tcp_test_app {
+	u32 total;
+	u32 sent;
+	u32 rcvd;
+	int mismatch;
+	int closed;
+};
+
+static struct tcp_test_app app;
+static u8 *tcp_test_buf;
+static int peer_mismatch;
+
+/* Check the data received by the peer against the data sent */
+static void tcp_test_peer_rx(const u8 *data, u32 len)
+{
+	u32 offset = tcp_peer.rcvd % TCP_TEST_BUF_SIZE;
+
+	if (offset + len > TCP_TEST_BUF_SIZE ||
+	    memcmp(tcp_test_buf + offset, data, len))
+		peer_mismatch = 1;
+}
+
+static void tcp_test_send_next(const void *conn)
+{
+	u32 offset = app.sent % TCP_TEST_BUF_SIZE;
+	u32 len = min((u32)TCP_TEST_CHUNK_SIZE, app.total - app.sent);
+
+	len = min(len, TCP_TEST_BUF_SIZE - offset);
+	tcp_send_data(conn, tcp_test_buf + offset, len);
+	app.sent += len;
+}
+
+static void tcp_test_cb(struct tcb_cb_data *cbd)
+{
+	switch (cbd->status) {
+	case TCP_CB_NEW_CONN:
+		tcp_test_send_next(cbd->conn);
+		break;
+	case TCP_CB_DATA_SENT:
+		if (app.sent < app.total)
+			tcp_test_send_next(cbd->conn);
+		else
+			tcp_close_conn(cbd->conn, 0);
+		break;
+	case TCP_CB_REMOTE_CLOSED:
+	case TCP_CB_CLOSED:
+		app.closed = 1;
+		break;
+	default:
+		break;
+	}
+}
+
+static void tcp_test_rx_cb(struct tcb_cb_data *cbd)
+{
+	switch (cbd->status) {
+	case TCP_CB_DATA_RCVD:
+		if (app.rcvd + cbd->datalen > TCP_TEST_BUF_SIZE ||
+		    memcmp(tcp_test_buf + app.rcvd, cbd->data, cbd->datalen))
+			app.mismatch = 1;
+
+		app.rcvd += cbd->datalen;
+		break;
+	case TCP_CB_REMOTE_CLOSED:
+	case TCP_CB_CLOSED:
+		app.closed = 1;
+		break;
+	default:
+		break;
+	}
+}
+
+static int tcp_test_setup(struct unit_test_state *uts, tcp_conn_cb cb)
+{
+	u32 i;
+
+	tcp_test_buf = malloc(TCP_TEST_BUF_SIZE);
+	ut_assertnonnull(tcp_test_buf);
+
+	for (i = 0; i < TCP_TEST_BUF_SIZE; i++)
+		tcp_test_buf[i] = (i * 7) + (i >> 12);
+
+	memset(&app, 0, sizeof(app));
+	peer_mismatch = 0;
+
+	ut_assertok(tcp_test_peer_setup(uts, cb));
+	tcp_peer.rx = tcp_test_peer_rx;
+
+	return 0;
+}
+
+static void tcp_test_cleanup(void)
+{
+	tcp_test_peer_cleanup();
+	free(tcp_test_buf);
+}
+
+static int tcp_test_transfer(struct unit_test_state *uts, u32 total,
+			     u32 drop_interval)
+{
+	ulong start, start_us, elapsed_us;
+
+	ut_assertok(tcp_test_setup(uts, tcp_test_cb));
+
+	tcp_peer.drop_interval = drop_interval;
+	app.total = total;
+
+	start = get_timer(0);
+	start_us = timer_get_us();
+
+	tcp_test_peer_send(TCP_SYN, 0);
+
+	while (!app.closed && get_timer(start) < TCP_TEST_TIMEOUT) {
+		tcp_periodic_check();
+		tcp_test_peer_flush();
+	}
+
+	elapsed_us = max(timer_get_us() - start_us, 1UL);
+
+	tcp_test_cleanup();
+
+	printf("TCP: %u bytes, %u segments (%u dropped) in %lu us, %llu KiB/s\n",
+	       tcp_peer.rcvd, tcp_peer.segs, tcp_peer.drops, elapsed_us,
+	       (u64)tcp_peer.rcvd * 1000000 / elapsed_us / 1024);
+
+	ut_asserteq(1, app.closed);
+	ut_asserteq(0, peer_mismatch);
+	ut_asserteq(total, tcp_peer.rcvd);
+
+	return 0;
+}
+
+/* Test sending data through a lossless wire and report the throughput */
+static int dm_test_net_tcp_tx(struct unit_test_state *uts)
+{
+	return tcp_test_transfer(uts, 16 << 20, 0);
+}
+DM_TEST(dm_test_net_tcp_tx, DM_TESTF_SCAN_FDT);
+
+/* Test that lost segments are recovered by retransmission */
+static int dm_test_net_tcp_tx_loss(struct unit_test_state *uts)
+{
+	return tcp_test_transfer(uts, 4 << 20, 50);
+}
+DM_TEST(dm_test_net_tcp_tx_loss, DM_TESTF_SCAN_FDT);
+
+/*
+ * Test that segments received out of order are reassembled, and that the
+ * window scale option and delayed ACKs are used
+ */
+static int dm_test_net_tcp_rx_ooo(struct unit_test_state *uts)
+{
+	static const u8 order[] = { 1, 0, 3, 4, 2, 5, 7, 6 };
+	u32 total = TCP_TEST_RX_SEGS * TCP_MSS;
+	struct tcp_stats st;
+	u32 i, j, seg, base;
+	ulong start;
+
+	ut_assertok(tcp_test_setup(uts, tcp_test_rx_cb));
+
+	tcp_test_peer_send(TCP_SYN, 0);
+	tcp_test_peer_flush();
+	ut_asserteq(TCP_RCV_WS, tcp_peer.ws);
+
+	base = tcp_peer.seq;
+
+	for (i = 0; i < TCP_TEST_RX_SEGS; i += ARRAY_SIZE(order)) {
+		for (j = 0; j < ARRAY_SIZE(order); j++) {
+			seg = i + order[j];
+			tcp_test_peer_send_data(TCP_ACK, base + seg * TCP_MSS,
+						tcp_peer.ack,
+						tcp_test_buf + seg * TCP_MSS,
+						TCP_MSS);
+		}
+
+		tcp_periodic_check();
+	}
+
+	/* All data must have been ACKed with the scaled window */
+	ut_asserteq(base + total, tcp_peer.rx_ack);
+	ut_asserteq(TCP_RCV_WND >> TCP_RCV_WS, tcp_peer.rx_wnd);
+
+	tcp_peer.seq = base + total;
+	tcp_test_peer_send(TCP_FIN | TCP_ACK, tcp_peer.ack);
+
+	start = get_timer(0);
+	while (!app.closed && get_timer(start) < TCP_TEST_TIMEOUT) {
+		tcp_periodic_check();
+		tcp_test_peer_flush();
+	}
+
+	tcp_test_cleanup();
+	tcp_get_stats(&st);
+
+	ut_asserteq(1, app.closed);
+	ut_asserteq(0, app.mismatch);
+	ut_asserteq(total, app.rcvd);
+
+	ut_assert(st.ooo_queued > 0);
+	ut_asserteq(st.ooo_queued, st.ooo_hits);
+	ut_asserteq(0, st.ooo_drops);
+	ut_asserteq(st.ooo_queued, st.dup_acks_out);
+
+	/* ACKs are cumulative, not one per segment */
+	ut_assert(tcp_peer.pure_acks < TCP_TEST_RX_SEGS);
+
+	return 0;
+}
+DM_TEST(dm_test_net_tcp_rx_ooo, DM_TESTF_SCAN_FDT);
@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Minimal TCP peer for the sandbox network tests
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <net.h>
+#include <asm/eth.h>
+#include <test/ut.h>
+
+#include "tcp_peer.h"
+
+struct tcp_test_peer tcp_peer;
+
+static void tcp_test_peer_queue_ack(u16 flags)
+{
+	if (tcp_peer.ack_num >= TCP_TEST_ACK_MAX)
+		return;
+
+	tcp_peer.acks[tcp_peer.ack_num] = tcp_peer.ack;
+	tcp_peer.ack_flags[tcp_peer.ack_num] = flags;
+	tcp_peer.ack_num++;
+}
+
+static int tcp_test_tx_handler(struct udevice *dev, void *packet,
+			       unsigned int len)
+{
+	struct ip_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct tcp_hdr tcp;
+	u32 seq, hdrlen, datalen;
+	u16 flags;
+	u8 *data, *opt;
+
+	if (ip->ip_p != IPPROTO_TCP)
+		return 0;
+
+	memcpy(&tcp, (void *)ip + IP_HDR_SIZE, sizeof(tcp));
+
+	if (ntohs(tcp.dst) != tcp_peer.port)
+		return 0;
+
+	flags = ntohs(tcp.flags);
+	hdrlen = ((flags >> TCP_HDR_LEN_SHIFT) & TCP_HDR_LEN_MASK) * 4;
+	data = (void *)ip + IP_HDR_SIZE + hdrlen;
+	datalen = ntohs(ip->ip_len) - IP_HDR_SIZE - hdrlen;
+	seq = ntohl(tcp.seq);
+
+	if (flags & TCP_SYN) {
+		opt = (u8 *)ip + IP_HDR_SIZE + TCP_HDR_SIZE;
+
+		/* MSS option is always followed by the window scale option */
+		if (hdrlen >= TCP_HDR_SIZE + 8 && opt[4] == TCP_OPT_WS)
+			tcp_peer.ws = opt[6];
+
+		tcp_peer.ack = seq + 1;
+		tcp_peer.seq++;
+		tcp_test_peer_queue_ack(TCP_ACK);
+		return 0;
+	}
+
+	tcp_peer.rx_ack = ntohl(tcp.ack);
+	tcp_peer.rx_wnd = ntohs(tcp.wnd);
+
+	if (!datalen && (flags & TCP_FLAG_MASK) == TCP_ACK)
+		tcp_peer.pure_acks++;
+
+	if (datalen) {
+		tcp_peer.segs++;
+
+		/* Simulate packet loss on the wire */
+		if (tcp_peer.drop_interval &&
+		    !(tcp_peer.segs % tcp_peer.drop_interval)) {
+			tcp_peer.drops++;
+			return 0;
+		}
+
+		/* Out-of-order segments are discarded */
+		if (seq == tcp_peer.ack) {
+			if (tcp_peer.rx)
+				tcp_peer.rx(data, datalen);
+
+			tcp_peer.rcvd += datalen;
+			tcp_peer.ack += datalen;
+		}
+
+		tcp_test_peer_queue_ack(TCP_ACK);
+	}
+
+	if ((flags & TCP_FIN) && seq + datalen == tcp_peer.ack) {
+		tcp_peer.fin = 1;
+		tcp_peer.ack++;
+		tcp_test_peer_queue_ack(TCP_ACK | TCP_FIN);
+	}
+
+	return 0;
+}
+
+void tcp_test_peer_reset(u16 port)
+{
+	memset(&tcp_peer, 0, sizeof(tcp_peer));
+	tcp_peer.ip = string_to_ip("1.1.2.2");
+	tcp_peer.ethaddr[0] = 0x02;
+	tcp_peer.ethaddr[5] = 0x22;
+	tcp_peer.port = port;
+	tcp_peer.seq = TCP_TEST_PEER_ISN;
+}
+
+void tcp_test_peer_send_data(u16 flags, u32 seq, u32 ack,
+			     const void *data, u32 len)
+{
+	uchar *pkt = net_rx_packets[0];
+	struct ethernet_hdr *et = (struct ethernet_hdr *)pkt;
+	struct ip_hdr *ip = (struct ip_hdr *)(pkt + ETHER_HDR_SIZE);
+	int optlen = (flags & TCP_SYN) ? 8 : 0;
+	int tcplen = TCP_HDR_SIZE + optlen;
+	struct {
+		__be32 sip;
+		__be32 dip;
+		u8 zero;
+		u8 prot;
+		__be16 len;
+		struct tcp_hdr tcp;
+		u8 opt[8 + TCP_MSS];
+	} __packed ph;
+
+	memset(&ph, 0, sizeof(ph));
+	ph.sip = tcp_peer.ip.s_addr;
+	ph.dip = net_ip.s_addr;
+	ph.prot = IPPROTO_TCP;
+	ph.len = htons(tcplen + len);
+	ph.tcp.src = htons(tcp_peer.port);
+	ph.tcp.dst = htons(TCP_TEST_PORT);
+	ph.tcp.seq = htonl(seq);
+	ph.tcp.ack = htonl(ack);
+	ph.tcp.flags = htons(((tcplen / 4) << TCP_HDR_LEN_SHIFT) | flags);
+	ph.tcp.wnd = htons(TCP_TEST_PEER_WND);
+
+	if (optlen) {
+		ph.opt[0] = TCP_OPT_MSS;
+		ph.opt[1] = 4;
+		ph.opt[2] = (TCP_MSS >> 8) & 0xff;
+		ph.opt[3] = TCP_MSS & 0xff;
+		ph.opt[4] = TCP_OPT_WS;
+		ph.opt[5] = 3;
+		ph.opt[6] = TCP_TEST_PEER_WS;
+		ph.opt[7] = TCP_OPT_EOL;
+	}
+
+	memcpy(ph.opt + optlen, data, len);
+	ph.tcp.chksum = compute_ip_checksum(&ph, 12 + tcplen + len);
+
+	memcpy(et->et_dest, eth_get_ethaddr(), ARP_HLEN);
+	memcpy(et->et_src, tcp_peer.ethaddr, ARP_HLEN);
+	et->et_protlen = htons(PROT_IP);
+
+	net_set_ip_header((uchar *)ip, net_ip, tcp_peer.ip);
+	ip->ip_len = htons(IP_HDR_SIZE + tcplen + len);
+	ip->ip_p = IPPROTO_TCP;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+
+	memcpy((void *)ip + IP_HDR_SIZE, &ph.tcp, tcplen + len);
+
+	net_process_received_packet(pkt, ETHER_HDR_SIZE + IP_HDR_SIZE + tcplen +
+				    len);
+}
+
+void tcp_test_peer_send(u16 flags, u32 ack)
+{
+	tcp_test_peer_send_data(flags, tcp_peer.seq, ack, NULL, 0);
+}
+
+void tcp_test_peer_flush(void)
+{
+	u32 i;
+
+	for (i = 0; i < tcp_peer.ack_num; i++) {
+		tcp_test_peer_send(tcp_peer.ack_flags[i], tcp_peer.acks[i]);
+		if (tcp_peer.ack_flags[i] & TCP_FIN)
+			tcp_peer.seq++;
+	}
+
+	tcp_peer.ack_num = 0;
+}
+
+int tcp_test_peer_setup(struct unit_test_state *uts, tcp_conn_cb cb)
+{
+	tcp_test_peer_reset(TCP_TEST_PEER_PORT);
+
+	env_set("ethact", "eth@10002000");
+	net_init();
+	eth_halt();
+	eth_set_current();
+	ut_assertok(eth_init());
+	net_ip = string_to_ip("1.1.2.1");
+
+	sandbox_eth_set_tx_handler(0, tcp_test_tx_handler);
+
+	tcp_start();
+	tcp_reset_stats();
+	if (cb)
+		ut_assertok(tcp_listen(htons(TCP_TEST_PORT), cb));
+
+	return 0;
+}
+
+void tcp_test_peer_cleanup(void)
+{
+	tcp_listen_stop(htons(TCP_TEST_PORT));
+	sandbox_eth_set_tx_handler(0, NULL);
+	eth_halt();
+}
@@ -0,0 +1,74 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Minimal TCP peer for the sandbox network tests. The sandbox ethernet driver
+ * is used as a loopback wire: segments sent by the TCP stack are handled by
+ * the peer, which queues the ACKs to be sent back by tcp_test_peer_flush().
+ */
+
+#ifndef __TEST_DM_TCP_PEER_H__
+#define __TEST_DM_TCP_PEER_H__
+
+#include <net.h>
+#include <net/tcp.h>
+#include <test/ut.h>
+
+#include "../../net/tcp.h"
+
+#define TCP_TEST_PORT		80
+#define TCP_TEST_PEER_PORT	40000
+#define TCP_TEST_PEER_ISN	1000
+#define TCP_TEST_PEER_WND	65535
+#define TCP_TEST_PEER_WS	2
+#define TCP_TEST_ACK_MAX	256
+
+struct tcp_test_peer {
+	struct in_addr ip;
+	u8 ethaddr[ARP_HLEN];
+	u16 port;
+
+	u32 seq;
+	u32 ack;
+
+	/* ACK numbers to be sent, one per received segment */
+	u32 acks[TCP_TEST_ACK_MAX];
+	u16 ack_flags[TCP_TEST_ACK_MAX];
+	u32 ack_num;
+
+	u32 drop_interval;
+	u32 segs;
+	u32 drops;
+
+	/* Called for data received in order, before rcvd is updated */
+	void (*rx)(const u8 *data, u32 len);
+	u32 rcvd;
+	int fin;
+
+	/* Window scale, ACK number and window advertised by the stack */
+	u32 ws;
+	u32 rx_ack;
+	u32 rx_wnd;
+	u32 pure_acks;
+};
+
+extern struct tcp_test_peer tcp_peer;
+
+/* Reset the peer for a new connection from the given port */
+void tcp_test_peer_reset(u16 port);
+
+/* Send a segment from the peer to the TCP stack */
+void tcp_test_peer_send_data(u16 flags, u32 seq, u32 ack,
+			     const void *data, u32 len);
+
+/* Send a segment without data from the peer to the TCP stack */
+void tcp_test_peer_send(u16 flags, u32 ack);
+
+/* Deliver the ACKs queued by the peer */
+void tcp_test_peer_flush(void);
+
+/* Bring up the loopback wire, and listen on TCP_TEST_PORT if cb is given */
+int tcp_test_peer_setup(struct unit_test_state *uts, tcp_conn_cb cb);
+
+/* Stop listening and bring down the loopback wire */
+void tcp_test_peer_cleanup(void);
+
+#endif /* __TEST_DM_TCP_PEER_H__ */
@@ -0,0 +1,394 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Sandbox tests for the TFTP client and server. The sandbox ethernet driver is
+ * used as a loopback wire, with a minimal TFTP peer answering the read request,
+ * or sending a write request, and sending the file with the negotiated window
+ * size (RFC 7440).
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <net.h>
+#include <net/tftp.h>
+#include <dm/test.h>
+#include <asm/eth.h>
+#include <test/ut.h>
+
+#define TFTP_TEST_SERVER_PORT	40000
+#define TFTP_TEST_WELL_KNOWN_PORT	69
+#define TFTP_TEST_LOAD_ADDR	0x1000000
+#define TFTP_TEST_FILE_SIZE	((4 << 20) + 123)
+#define TFTP_TEST_BLKSIZE_MAX	1468
+#define TFTP_TEST_TIMEOUT	30000
+
+/* TFTP opcodes */
+#define TFTP_TEST_RRQ		1
+#define TFTP_TEST_WRQ		2
+#define TFTP_TEST_DATA		3
+#define TFTP_TEST_ACK		4
+#define TFTP_TEST_OACK		6
+
+struct tftp_test_server {
+	struct in_addr ip;
+	u8 ethaddr[ARP_HLEN];
+
+	/* ARP request to be answered */
+	int arp_pending;
+	u8 arp_sha[ARP_HLEN];
+	struct in_addr arp_spa;
+
+	u16 client_port;
+	u32 blksize;
+	u32 windowsize;
+	u32 nblocks;
+
+	/* OACK to be sent, and first block of the window to be sent */
+	int oack_pending;
+	u32 next_block;
+
+	u32 drop_block;
+	u32 drops;
+
+	u32 acks;
+	u32 blocks;
+};
+
+static struct tftp_test_server server;
+static u8 *tftp_test_buf;
+
+static void tftp_test_parse_options(const char *opt, const char *end)
+{
+	const char *val;
+
+	while (opt < end) {
+		val = opt + strnlen(opt, end - opt) + 1;
+		if (val >= end)
+			break;
+
+		if (!strcmp(opt, "blksize"))
+			server.blksize = min_t(u32, TFTP_TEST_BLKSIZE_MAX,
+					       simple_strtoul(val, NULL, 10));
+		else if (!strcmp(opt, "windowsize"))
+			server.windowsize = simple_strtoul(val, NULL, 10);
+
+		opt = val + strnlen(val, end - val) + 1;
+	}
+}
+
+static int tftp_test_tx_handler(struct udevice *dev, void *packet,
+				unsigned int len)
+{
+	struct ethernet_hdr *et = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct arp_hdr *arp = packet + ETHER_HDR_SIZE;
+	u8 *data = packet + ETHER_HDR_SIZE + IP_UDP_HDR_SIZE;
+	char *end = (char *)ip + ntohs(ip->ip_len);
+	char *opt = (char *)data + 2;
+	u32 block;
+
+	if (ntohs(et->et_protlen) == PROT_ARP) {
+		if (ntohs(arp->ar_op) == ARPOP_REQUEST) {
+			memcpy(server.arp_sha, &arp->ar_sha, ARP_HLEN);
+			server.arp_spa = net_read_ip(&arp->ar_spa);
+			server.arp_pending = 1;
+		}
+		return 0;
+	}
+
+	if (ntohs(et->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	switch ((data[0] << 8) | data[1]) {
+	case TFTP_TEST_RRQ:
+		server.client_port = ntohs(ip->udp_src);
+
+		/* Skip the file name and the transfer mode */
+		opt += strnlen(opt, end - opt) + 1;
+		opt += strnlen(opt, end - opt) + 1;
+		tftp_test_parse_options(opt, end);
+		server.nblocks = TFTP_TEST_FILE_SIZE / server.blksize + 1;
+		server.oack_pending = 1;
+		break;
+	case TFTP_TEST_OACK:
+		/* The TFTP server accepted our write request */
+		server.client_port = ntohs(ip->udp_src);
+		tftp_test_parse_options(opt, end);
+		server.nblocks = TFTP_TEST_FILE_SIZE / server.blksize + 1;
+		server.next_block = 1;
+		break;
+	case TFTP_TEST_ACK:
+		server.acks++;
+		block = (data[2] << 8) | data[3];
+		if (block < server.nblocks)
+			server.next_block = block + 1;
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static void tftp_test_send_arp_reply(void)
+{
+	uchar *pkt = net_rx_packets[0];
+	struct ethernet_hdr *et = (struct ethernet_hdr *)pkt;
+	struct arp_hdr *arp = (struct arp_hdr *)(pkt + ETHER_HDR_SIZE);
+
+	memcpy(et->et_dest, server.arp_sha, ARP_HLEN);
+	memcpy(et->et_src, server.ethaddr, ARP_HLEN);
+	et->et_protlen = htons(PROT_ARP);
+
+	arp->ar_hrd = htons(ARP_ETHER);
+	arp->ar_pro = htons(PROT_IP);
+	arp->ar_hln = ARP_HLEN;
+	arp->ar_pln = ARP_PLEN;
+	arp->ar_op = htons(ARPOP_REPLY);
+	memcpy(&arp->ar_sha, server.ethaddr, ARP_HLEN);
+	net_write_ip(&arp->ar_spa, server.ip);
+	memcpy(&arp->ar_tha, server.arp_sha, ARP_HLEN);
+	net_write_ip(&arp->ar_tpa, server.arp_spa);
+
+	net_process_received_packet(pkt, ETHER_HDR_SIZE + ARP_HDR_SIZE);
+}
+
+static void tftp_test_send_udp(const void *data, u32 len)
+{
+	uchar *pkt = net_rx_packets[0];
+	struct ethernet_hdr *et = (struct ethernet_hdr *)pkt;
+	struct ip_udp_hdr *ip = (struct ip_udp_hdr *)(pkt + ETHER_HDR_SIZE);
+
+	memcpy(et->et_dest, eth_get_ethaddr(), ARP_HLEN);
+	memcpy(et->et_src, server.ethaddr, ARP_HLEN);
+	et->et_protlen = htons(PROT_IP);
+
+	net_set_ip_header((uchar *)ip, net_ip, server.ip);
+	ip->ip_len = htons(IP_UDP_HDR_SIZE + len);
+	ip->ip_p = IPPROTO_UDP;
+	ip->ip_sum = compute_ip_checksum(ip, IP_HDR_SIZE);
+
+	ip->udp_src = htons(TFTP_TEST_SERVER_PORT);
+	ip->udp_dst = htons(server.client_port);
+	ip->udp_len = htons(UDP_HDR_SIZE + len);
+	ip->udp_xsum = 0;
+
+	memcpy((void *)ip + IP_UDP_HDR_SIZE, data, len);
+
+	net_process_received_packet(pkt, ETHER_HDR_SIZE + IP_UDP_HDR_SIZE +
+				    len);
+}
+
+static void tftp_test_send_oack(void)
+{
+	char oack[64];
+	int len = 2;
+
+	oack[0] = 0;
+	oack[1] = TFTP_TEST_OACK;
+	len += sprintf(oack + len, "blksize%c%u%c", 0, server.blksize, 0);
+	if (server.windowsize > 1)
+		len += sprintf(oack + len, "windowsize%c%u%c", 0,
+			       server.windowsize, 0);
+
+	tftp_test_send_udp(oack, len);
+}
+
+static void tftp_test_send_block(u32 block)
+{
+	static u8 pkt[4 + TFTP_TEST_BLKSIZE_MAX];
+	u32 offset = (block - 1) * server.blksize;
+	u32 len = min_t(u32, server.blksize, TFTP_TEST_FILE_SIZE - offset);
+
+	server.blocks++;
+
+	/* Simulate packet loss on the wire */
+	if (block == server.drop_block) {
+		server.drop_block = 0;
+		server.drops++;
+		return;
+	}
+
+	pkt[0] = 0;
+	pkt[1] = TFTP_TEST_DATA;
+	pkt[2] = (block >> 8) & 0xff;
+	pkt[3] = block & 0xff;
+	memcpy(pkt + 4, tftp_test_buf + offset, len);
+
+	tftp_test_send_udp(pkt, 4 + len);
+}
+
+/* Send a window of blocks, restarting from the block requested by an ACK */
+static void tftp_test_send_window(void)
+{
+	u32 block = server.next_block;
+	u32 i;
+
+	server.next_block = 0;
+
+	for (i = 0; i < server.windowsize && block + i <= server.nblocks;
+	     i++) {
+		tftp_test_send_block(block + i);
+		if (server.next_block)
+			break;
+	}
+}
+
+/* Send a write request to the TFTP server, asking for the window size */
+static void tftp_test_send_wrq(u32 windowsize)
+{
+	char wrq[80];
+	int len = 2;
+
+	wrq[0] = 0;
+	wrq[1] = TFTP_TEST_WRQ;
+	len += sprintf(wrq + len, "tftp-test.bin%coctet%c", 0, 0);
+	len += sprintf(wrq + len, "blksize%c%u%c", 0, TFTP_TEST_BLKSIZE_MAX, 0);
+	len += sprintf(wrq + len, "windowsize%c%u%c", 0, windowsize, 0);
+
+	server.client_port = TFTP_TEST_WELL_KNOWN_PORT;
+	tftp_test_send_udp(wrq, len);
+}
+
+static int tftp_test_setup(struct unit_test_state *uts, u32 windowsize,
+			   u32 drop_block)
+{
+	char ws[12];
+	u32 i;
+
+	tftp_test_buf = malloc(TFTP_TEST_FILE_SIZE);
+	ut_assertnonnull(tftp_test_buf);
+
+	for (i = 0; i < TFTP_TEST_FILE_SIZE; i++)
+		tftp_test_buf[i] = (i * 7) + (i >> 12);
+
+	memset(&server, 0, sizeof(server));
+	server.ip = string_to_ip("1.1.2.2");
+	server.ethaddr[0] = 0x02;
+	server.ethaddr[5] = 0x22;
+	server.blksize = 512;
+	server.windowsize = 1;
+	server.drop_block = drop_block;
+
+	sprintf(ws, "%u", windowsize);
+	env_set("tftpwindowsize", ws);
+	env_set("ethact", "eth@10002000");
+	net_init();
+	eth_halt();
+	eth_set_current();
+	ut_assertok(eth_init());
+	net_ip = string_to_ip("1.1.2.1");
+	net_server_ip = server.ip;
+	strcpy(net_boot_file_name, "tftp-test.bin");
+	load_addr = TFTP_TEST_LOAD_ADDR;
+	net_boot_file_size = 0;
+
+	sandbox_eth_set_tx_handler(0, tftp_test_tx_handler);
+	net_set_state(NETLOOP_CONTINUE);
+
+	return 0;
+}
+
+/* Play the peer until the transfer started by the caller is over */
+static int tftp_test_run(struct unit_test_state *uts, u32 windowsize,
+			 const char *name)
+{
+	ulong start, start_us, elapsed_us;
+
+	start = get_timer(0);
+	start_us = timer_get_us();
+
+	while (net_state == NETLOOP_CONTINUE &&
+	       get_timer(start) < TFTP_TEST_TIMEOUT) {
+		if (server.arp_pending) {
+			server.arp_pending = 0;
+			tftp_test_send_arp_reply();
+		} else if (server.oack_pending) {
+			server.oack_pending = 0;
+			tftp_test_send_oack();
+		} else if (server.next_block) {
+			tftp_test_send_window();
+		} else {
+			/* Nothing to send, the transfer is stuck */
+			break;
+		}
+	}
+
+	elapsed_us = max(timer_get_us() - start_us, 1UL);
+
+	net_set_udp_handler(NULL);
+	net_set_timeout_handler(0, NULL);
+	sandbox_eth_set_tx_handler(0, NULL);
+	eth_halt();
+	env_set("tftpwindowsize", NULL);
+
+	printf("%s: windowsize %u, %u bytes, %u blocks (%u dropped), %u ACKs in %lu us, %llu KiB/s\n",
+	       name, server.windowsize, net_boot_file_size, server.blocks,
+	       server.drops, server.acks, elapsed_us,
+	       (u64)net_boot_file_size * 1000000 / elapsed_us / 1024);
+
+	ut_asserteq(NETLOOP_SUCCESS, net_state);
+	ut_asserteq(windowsize, server.windowsize);
+	ut_asserteq(TFTP_TEST_FILE_SIZE, net_boot_file_size);
+	ut_asserteq(0, memcmp(tftp_test_buf,
+			       map_sysmem(TFTP_TEST_LOAD_ADDR,
+					  TFTP_TEST_FILE_SIZE),
+			       TFTP_TEST_FILE_SIZE));
+
+	/* One ACK per window, plus ACK(0) of the OACK and the lost block */
+	ut_assert(server.acks <=
+		  DIV_ROUND_UP(server.nblocks, windowsize) + 1 + server.drops);
+
+	free(tftp_test_buf);
+
+	return 0;
+}
+
+static int tftp_test_transfer(struct unit_test_state *uts, u32 windowsize,
+			      u32 drop_block)
+{
+	ut_assertok(tftp_test_setup(uts, windowsize, drop_block));
+	tftp_start(TFTPGET);
+
+	return tftp_test_run(uts, windowsize, "TFTP");
+}
+
+static int tftp_test_put(struct unit_test_state *uts, u32 windowsize,
+			 u32 drop_block)
+{
+	ut_assertok(tftp_test_setup(uts, windowsize, drop_block));
+	tftp_start_server();
+	tftp_test_send_wrq(windowsize);
+
+	return tftp_test_run(uts, windowsize, "TFTP server");
+}
+
+/* Test that the number of ACKs is reduced by the window size option */
+static int dm_test_net_tftp_windowsize(struct unit_test_state *uts)
+{
+	ut_assertok(tftp_test_transfer(uts, 1, 0));
+	ut_assertok(tftp_test_transfer(uts, 4, 0));
+	ut_assertok(tftp_test_transfer(uts, 16, 0));
+
+	return 0;
+}
+DM_TEST(dm_test_net_tftp_windowsize, DM_TESTF_SCAN_FDT);
+
+/* Test that a block lost in the middle of a window is sent again */
+static int dm_test_net_tftp_windowsize_loss(struct unit_test_state *uts)
+{
+	return tftp_test_transfer(uts, 8, 100);
+}
+DM_TEST(dm_test_net_tftp_windowsize_loss, DM_TESTF_SCAN_FDT);
+
+/* Test that the TFTP server answers a write request with an OACK */
+static int dm_test_net_tftpsrv_windowsize(struct unit_test_state *uts)
+{
+	ut_assertok(tftp_test_put(uts, 1, 0));
+	ut_assertok(tftp_test_put(uts, 8, 0));
+	ut_assertok(tftp_test_put(uts, 8, 100));
+
+	return 0;
+}
+DM_TEST(dm_test_net_tftpsrv_windowsize, DM_TESTF_SCAN_FDT);
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Known answer tests of the hash algorithms, through both the one-shot and
+ * the progressive interfaces of common/hash.c, and a benchmark of their
+ * throughput.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <hash.h>
+#include <malloc.h>
+#include <test/bench.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define HASH_TEST(_name, _flags)	UNIT_TEST(_name, _flags, hash_test)
+
+#define HASH_TEST_LEN		1000
+#define HASH_TEST_ALIGN		4
+
+static const char *const hash_test_algos[] = { "md5", "sha1", "sha256" };
+
+#define HASH_TEST_LONG \
+	"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn" \
+	"hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu"
+
+/*
+ * Test vectors from RFC 1321, FIPS 180-2 and their usual companions. The
+ * input is repeated the given number of times, if any.
+ */
+static const struct {
+	const char *algo;
+	const char *input;
+	const char *digest;
+	int repeat;
+} hash_test_vectors[] = {
+	{ "md5", "", "d41d8cd98f00b204e9800998ecf8427e" },
+	{ "md5", "abc", "900150983cd24fb0d6963f7d28e17f72" },
+	{ "md5", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+	  "8215ef0796a20bcaaae116d3876c664a" },
+	{ "md5", HASH_TEST_LONG, "03dd8807a93175fb062dfb55dc7d359c" },
+	{ "md5", "a", "7707d6ae4e027c70eea2a935c2296f21", 1000000 },
+	{ "sha1", "", "da39a3ee5e6b4b0d3255bfef95601890afd80709" },
+	{ "sha1", "abc", "a9993e364706816aba3e25717850c26c9cd0d89d" },
+	{ "sha1", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+	  "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+	{ "sha1", HASH_TEST_LONG, "a49b2446a02c645bf419f995b67091253a04a259" },
+	{ "sha1", "a", "34aa973cd4c4daa4f61eeb2bdbad27316534016f", 1000000 },
+	{ "sha256", "",
+	  "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+	{ "sha256", "abc",
+	  "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+	{ "sha256", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+	  "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+	{ "sha256", HASH_TEST_LONG,
+	  "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1" },
+	{ "sha256", "a",
+	  "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+	  1000000 },
+};
+
+static int hash_test_kat(struct unit_test_state *uts)
+{
+	u8 expect[HASH_MAX_DIGEST_SIZE], digest[HASH_MAX_DIGEST_SIZE];
+	struct hash_algo *algo;
+	int i, size, len, pos, inlen;
+	u8 *buf;
+
+	for (i = 0; i < ARRAY_SIZE(hash_test_vectors); i++) {
+		/* Skip the algorithms which are not enabled */
+		if (hash_lookup_algo(hash_test_vectors[i].algo, &algo))
+			continue;
+
+		ut_assertok(hash_parse_string(algo->name,
+					      hash_test_vectors[i].digest,
+					      expect));
+
+		inlen = strlen(hash_test_vectors[i].input);
+		len = inlen * max(hash_test_vectors[i].repeat, 1);
+
+		/* Hash from an odd address to cover the unaligned path */
+		buf = malloc(len + 1);
+		ut_assertnonnull(buf);
+		for (pos = 0; pos < len; pos += inlen)
+			memcpy(buf + 1 + pos, hash_test_vectors[i].input, inlen);
+
+		size = sizeof(digest);
+		ut_assertok(hash_block(algo->name, buf + 1, len, digest, &size));
+		free(buf);
+
+		ut_asserteq(algo->digest_size, size);
+		ut_asserteq(0, memcmp(expect, digest, size));
+	}
+
+	return 0;
+}
+HASH_TEST(hash_test_kat, 0);
+
+/*
+ * Hashing unaligned data in pieces of many sizes must give the same digest
+ * as hashing it in one go.
+ */
+static int hash_test_progressive(struct unit_test_state *uts)
+{
+	u8 expect[HASH_MAX_DIGEST_SIZE], digest[HASH_MAX_DIGEST_SIZE];
+	u8 buf[HASH_TEST_LEN + HASH_TEST_ALIGN];
+	struct hash_algo *algo;
+	int i, align, piece, pos, len;
+	void *ctx;
+
+	for (i = 0; i < ARRAY_SIZE(hash_test_algos); i++) {
+		if (hash_progressive_lookup_algo(hash_test_algos[i], &algo))
+			continue;
+
+		ut_fill_pattern(buf, HASH_TEST_LEN, i);
+		algo->hash_func_ws(buf, HASH_TEST_LEN, expect,
+				   algo->chunk_size);
+
+		for (align = 0; align < HASH_TEST_ALIGN; align++) {
+			ut_fill_pattern(buf + align, HASH_TEST_LEN, i);
+
+			for (piece = 1; piece <= 129; piece += 8) {
+				ut_assertok(algo->hash_init(algo, &ctx));
+
+				for (pos = 0; pos < HASH_TEST_LEN; pos += len) {
+					len = min(piece, HASH_TEST_LEN - pos);
+					ut_assertok(algo->hash_update(algo, ctx,
+						buf + align + pos, len,
+						pos + len == HASH_TEST_LEN));
+				}
+
+				ut_assertok(algo->hash_finish(algo, ctx, digest,
+							      sizeof(digest)));
+				ut_asserteq(0, memcmp(expect, digest,
+						      algo->digest_size));
+			}
+		}
+	}
+
+	return 0;
+}
+HASH_TEST(hash_test_progressive, 0);
+
+/* Throughput of each algorithm */
+static int hash_test_bench(struct unit_test_state *uts)
+{
+	u8 digest[HASH_MAX_DIGEST_SIZE];
+	struct hash_algo *algo;
+	ulong start;
+	u8 *buf;
+	int i, j;
+
+	buf = malloc(UT_BENCH_SIZE);
+	ut_assertnonnull(buf);
+
+	ut_fill_pattern(buf, UT_BENCH_SIZE, 5);
+
+	for (i = 0; i < ARRAY_SIZE(hash_test_algos); i++) {
+		if (hash_lookup_algo(hash_test_algos[i], &algo))
+			continue;
+
+		start = timer_get_us();
+		for (j = 0; j < UT_BENCH_LOOPS; j++)
+			algo->hash_func_ws(buf, UT_BENCH_SIZE, digest,
+					   algo->chunk_size);
+		ut_bench_report(algo->name, start);
+	}
+
+	free(buf);
+
+	return 0;
+}
+HASH_TEST(hash_test_bench, 0);
+
+int do_ut_hash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test, hash_test);
+	const int n_ents = ll_entry_count(struct unit_test, hash_test);
+
+	return cmd_ut_category("hash", tests, n_ents, argc, argv);
+}
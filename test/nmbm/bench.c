@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Benchmarks of the NMBM core, using the in-memory NAND simulator.
+ *
+ * The chip operations and the chip busy time modelled by the simulator are
+ * reproducible, and are the numbers to compare between NMBM changes. The
+ * host time is printed as well, it includes the CPU time spent by NMBM.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <div64.h>
+#include <test/nmbm.h>
+#include <test/ut.h>
+
+#include "nmbm-debug.h"
+#include "nmbm-sim.h"
+
+#define NMBM_BENCH_READ_SIZE		(8 * NMBM_SIM_ERASESIZE)
+#define NMBM_BENCH_REMAPS		4
+
+static void nmbm_bench_report(const char *name, struct nmbm_sim *sim,
+			      ulong host_us, uint64_t bytes)
+{
+	uint64_t busy_us = lldiv(sim->stats.busy_ns, 1000);
+
+	printf("%-24s %6u calls %6u rd %6u wr %4u er %8llu us chip %8lu us host",
+	       name, sim->stats.read_calls, sim->stats.pages_read,
+	       sim->stats.pages_written, sim->stats.blocks_erased, busy_us,
+	       host_us);
+
+	if (bytes && busy_us)
+		printf(" %6llu KiB/s", lldiv(bytes * 1000000 / 1024, busy_us));
+
+	printf("\n");
+}
+
+/*
+ * Pages written and blocks erased for the info tables, excluding the user
+ * data and the erasure of the new blocks
+ */
+static void nmbm_bench_report_remap(struct nmbm_sim *sim, uint32_t remaps,
+				    uint32_t data_pages)
+{
+	printf("%-24s %6u wr %4u er for %u remapped blocks\n", "",
+	       sim->stats.pages_written - data_pages,
+	       sim->stats.blocks_erased - remaps, remaps);
+}
+
+static struct nmbm_sim *nmbm_bench_create(void)
+{
+	return nmbm_sim_create(NMBM_SIM_BLOCK_COUNT, NMBM_SIM_ERASESIZE,
+			       NMBM_SIM_WRITESIZE, NMBM_SIM_OOBSIZE);
+}
+
+static struct nmbm_instance *nmbm_bench_attach(struct nmbm_sim *sim,
+					       const char *name, int flags)
+{
+	struct nmbm_instance *ni;
+	ulong start;
+
+	nmbm_sim_reset_stats(sim);
+	start = timer_get_us();
+	ni = nmbm_sim_attach(sim, NMBM_SIM_MAX_RATIO, flags);
+	nmbm_bench_report(name, sim, timer_get_us() - start, 0);
+
+	return ni;
+}
+
+static void nmbm_bench_detach(struct nmbm_instance *ni)
+{
+	nmbm_detach(ni);
+	free(ni);
+}
+
+/* Cost of creating the management area and attaching to it */
+static int nmbm_test_bench_attach(struct unit_test_state *uts)
+{
+	struct nmbm_instance *ni;
+	struct nmbm_sim *sim;
+	uint32_t ba, page;
+	u8 *raw;
+
+	sim = nmbm_bench_create();
+	ut_assertnonnull(sim);
+
+	/* A few factory bad blocks in the management area */
+	nmbm_sim_set_factory_bad(sim, NMBM_SIM_BLOCK_COUNT - 3);
+	nmbm_sim_set_factory_bad(sim, NMBM_SIM_BLOCK_COUNT - 9);
+
+	ni = nmbm_bench_attach(sim, "create", NMBM_F_CREATE);
+	ut_assertnonnull(ni);
+	nmbm_bench_detach(ni);
+
+	ni = nmbm_bench_attach(sim, "attach", 0);
+	ut_assertnonnull(ni);
+
+	/* Fill the hint area to measure the attach by scanning */
+	for (ba = 0; ba < NMBM_SIM_BLOCK_COUNT; ba++) {
+		if (nmbm_debug_get_phys_block_type(ni, ba) ==
+		    NMBM_BLOCK_SIGNATURE)
+			break;
+	}
+	ut_assert(ba < NMBM_SIM_BLOCK_COUNT);
+	nmbm_bench_detach(ni);
+
+	raw = sim->data + (size_t)ba * sim->pages_per_block *
+	      sim->rawpage_size;
+	for (page = 1; page < sim->pages_per_block; page++)
+		memcpy(raw + page * sim->rawpage_size, raw, sim->rawpage_size);
+
+	ni = nmbm_bench_attach(sim, "attach (scan)", 0);
+	ut_assertnonnull(ni);
+	nmbm_bench_detach(ni);
+
+	nmbm_sim_destroy(sim);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_bench_attach, 0);
+
+/* Sequential read throughput */
+static int nmbm_test_bench_read(struct unit_test_state *uts)
+{
+	static const char * const names[] = { "read", "read (read_pages)" };
+	struct nmbm_instance *ni;
+	struct nmbm_sim *sim;
+	size_t retlen;
+	ulong start;
+	u8 *buf;
+	int i;
+
+	sim = nmbm_bench_create();
+	ut_assertnonnull(sim);
+
+	buf = malloc(NMBM_BENCH_READ_SIZE);
+	ut_assertnonnull(buf);
+	nmbm_sim_fill_pattern(buf, NMBM_BENCH_READ_SIZE, 1);
+
+	ni = nmbm_sim_attach(sim, NMBM_SIM_MAX_RATIO, NMBM_F_CREATE);
+	ut_assertnonnull(ni);
+	ut_assertok(nmbm_erase_block_range(ni, 0, NMBM_BENCH_READ_SIZE, NULL));
+	ut_assertok(nmbm_write_range(ni, 0, NMBM_BENCH_READ_SIZE, buf,
+				     NMBM_MODE_PLACE_OOB, NULL));
+	nmbm_bench_detach(ni);
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		sim->read_pages = i;
+		ni = nmbm_sim_attach(sim, NMBM_SIM_MAX_RATIO, 0);
+		ut_assertnonnull(ni);
+
+		nmbm_sim_reset_stats(sim);
+		start = timer_get_us();
+		ut_assertok(nmbm_read_range(ni, 0, NMBM_BENCH_READ_SIZE, buf,
+					    NMBM_MODE_PLACE_OOB, &retlen));
+		nmbm_bench_report(names[i], sim, timer_get_us() - start,
+				  NMBM_BENCH_READ_SIZE);
+		ut_asserteq(NMBM_BENCH_READ_SIZE, retlen);
+
+		nmbm_bench_detach(ni);
+	}
+
+	free(buf);
+	nmbm_sim_destroy(sim);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_bench_read, 0);
+
+/* Write amplification of the info table updates caused by remapping */
+static int nmbm_test_bench_remap(struct unit_test_state *uts)
+{
+	struct nmbm_instance *ni;
+	struct nmbm_sim *sim;
+	ulong start;
+	u8 *buf;
+	int i;
+
+	sim = nmbm_bench_create();
+	ut_assertnonnull(sim);
+
+	buf = malloc(NMBM_SIM_ERASESIZE);
+	ut_assertnonnull(buf);
+	nmbm_sim_fill_pattern(buf, NMBM_SIM_ERASESIZE, 2);
+
+	ni = nmbm_sim_attach(sim, NMBM_SIM_MAX_RATIO, NMBM_F_CREATE);
+	ut_assertnonnull(ni);
+
+	/* Baseline: writing a block without remapping */
+	nmbm_sim_reset_stats(sim);
+	start = timer_get_us();
+	ut_assertok(nmbm_erase_block_range(ni, 0, NMBM_SIM_ERASESIZE, NULL));
+	ut_assertok(nmbm_write_range(ni, 0, NMBM_SIM_ERASESIZE, buf,
+				     NMBM_MODE_PLACE_OOB, NULL));
+	nmbm_bench_report("write block", sim, timer_get_us() - start, 0);
+
+	/* Every block wears out when it is erased */
+	nmbm_sim_reset_stats(sim);
+	start = timer_get_us();
+	for (i = 1; i <= NMBM_BENCH_REMAPS; i++) {
+		nmbm_sim_set_worn(sim, i);
+		ut_assertok(nmbm_erase_block_range(ni, i * NMBM_SIM_ERASESIZE,
+						   NMBM_SIM_ERASESIZE, NULL));
+		ut_assertok(nmbm_write_range(ni, i * NMBM_SIM_ERASESIZE,
+					     NMBM_SIM_ERASESIZE, buf,
+					     NMBM_MODE_PLACE_OOB, NULL));
+	}
+	nmbm_bench_report("write block + remap", sim,
+			  timer_get_us() - start, 0);
+	nmbm_bench_report_remap(sim, NMBM_BENCH_REMAPS,
+				NMBM_BENCH_REMAPS * sim->pages_per_block);
+
+	/* All blocks of a range wear out when the range is erased */
+	nmbm_sim_reset_stats(sim);
+	start = timer_get_us();
+	for (i = 1; i <= NMBM_BENCH_REMAPS; i++)
+		nmbm_sim_set_worn(sim, NMBM_BENCH_REMAPS + i);
+	ut_assertok(nmbm_erase_block_range(ni, (NMBM_BENCH_REMAPS + 1) *
+					   NMBM_SIM_ERASESIZE,
+					   NMBM_BENCH_REMAPS *
+					   NMBM_SIM_ERASESIZE, NULL));
+	nmbm_bench_report("erase range + remap", sim,
+			  timer_get_us() - start, 0);
+	nmbm_bench_report_remap(sim, NMBM_BENCH_REMAPS, 0);
+
+	nmbm_bench_detach(ni);
+	free(buf);
+	nmbm_sim_destroy(sim);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_bench_remap, 0);
@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Unit tests for NAND mapped-block management (NMBM)
+ */
+
+#include <common.h>
+#include <command.h>
+#include <test/nmbm.h>
+#include <test/suites.h>
+#include <test/ut.h>
+
+int do_ut_nmbm(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test, nmbm_test);
+	const int n_ents = ll_entry_count(struct unit_test, nmbm_test);
+
+	return cmd_ut_category("nmbm", tests, n_ents, argc, argv);
+}
@@ -0,0 +1,535 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Tests for the NMBM core, using the in-memory NAND simulator as lower device
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <test/nmbm.h>
+#include <test/ut.h>
+
+#include "nmbm-debug.h"
+#include "nmbm-sim.h"
+
+/* Size of the test data, spanning a few blocks */
+#define NMBM_TEST_DATA_BLOCKS		8
+#define NMBM_TEST_DATA_SIZE		(NMBM_TEST_DATA_BLOCKS * \
+					 NMBM_SIM_ERASESIZE)
+
+/* Upper bound of power cut points of a single operation */
+#define NMBM_TEST_MAX_CUTS		256
+
+struct nmbm_test_ctx {
+	struct nmbm_sim *sim;
+	struct nmbm_instance *ni;
+	u8 *data;
+	u8 *buf;
+};
+
+static int nmbm_test_setup(struct unit_test_state *uts,
+			   struct nmbm_test_ctx *ctx)
+{
+	ctx->ni = NULL;
+
+	ctx->sim = nmbm_sim_create(NMBM_SIM_BLOCK_COUNT, NMBM_SIM_ERASESIZE,
+				   NMBM_SIM_WRITESIZE, NMBM_SIM_OOBSIZE);
+	ut_assertnonnull(ctx->sim);
+
+	ctx->data = malloc(NMBM_TEST_DATA_SIZE);
+	ut_assertnonnull(ctx->data);
+
+	ctx->buf = malloc(NMBM_TEST_DATA_SIZE);
+	ut_assertnonnull(ctx->buf);
+
+	nmbm_sim_fill_pattern(ctx->data, NMBM_TEST_DATA_SIZE, 0x4e4d424d);
+
+	return 0;
+}
+
+static void nmbm_test_teardown(struct nmbm_test_ctx *ctx)
+{
+	if (ctx->ni) {
+		nmbm_detach(ctx->ni);
+		free(ctx->ni);
+	}
+
+	free(ctx->buf);
+	free(ctx->data);
+	nmbm_sim_destroy(ctx->sim);
+}
+
+/* Attach to the simulator, replacing the current instance */
+static int nmbm_test_attach(struct unit_test_state *uts,
+			    struct nmbm_test_ctx *ctx, int flags)
+{
+	if (ctx->ni) {
+		nmbm_detach(ctx->ni);
+		free(ctx->ni);
+	}
+
+	ctx->ni = nmbm_sim_attach(ctx->sim, NMBM_SIM_MAX_RATIO, flags);
+	ut_assertnonnull(ctx->ni);
+
+	return 0;
+}
+
+/* Forget the current instance without detaching, as on power loss */
+static void nmbm_test_drop(struct nmbm_test_ctx *ctx)
+{
+	free(ctx->ni);
+	ctx->ni = NULL;
+}
+
+static int nmbm_test_write_data(struct unit_test_state *uts,
+				struct nmbm_test_ctx *ctx, uint64_t addr,
+				size_t size)
+{
+	size_t retlen;
+
+	ut_assertok(nmbm_erase_block_range(ctx->ni, addr, size, NULL));
+	ut_assertok(nmbm_write_range(ctx->ni, addr, size, ctx->data + addr,
+				     NMBM_MODE_PLACE_OOB, &retlen));
+	ut_asserteq(size, retlen);
+
+	return 0;
+}
+
+static int nmbm_test_check_data(struct unit_test_state *uts,
+				struct nmbm_test_ctx *ctx, uint64_t addr,
+				size_t size)
+{
+	size_t retlen;
+
+	memset(ctx->buf, 0, size);
+	ut_assertok(nmbm_read_range(ctx->ni, addr, size, ctx->buf,
+				    NMBM_MODE_PLACE_OOB, &retlen));
+	ut_asserteq(size, retlen);
+	ut_asserteq(0, memcmp(ctx->data + addr, ctx->buf, size));
+
+	return 0;
+}
+
+/* Find the first physical block of the given type */
+static uint32_t nmbm_test_find_block(struct nmbm_instance *ni, char type)
+{
+	uint32_t ba;
+
+	for (ba = 0; ba < NMBM_SIM_BLOCK_COUNT; ba++) {
+		if (nmbm_debug_get_phys_block_type(ni, ba) == type)
+			return ba;
+	}
+
+	return NMBM_SIM_BLOCK_COUNT;
+}
+
+/* Test creating the management area and attaching to it again */
+static int nmbm_test_create(struct unit_test_state *uts)
+{
+	struct nmbm_test_ctx ctx;
+	uint64_t size;
+
+	ut_assertok(nmbm_test_setup(uts, &ctx));
+
+	/* There is nothing to attach to on an empty chip */
+	ut_assertnull(nmbm_sim_attach(ctx.sim, NMBM_SIM_MAX_RATIO, 0));
+
+	ut_assertok(nmbm_test_attach(uts, &ctx, NMBM_F_CREATE));
+	size = nmbm_get_avail_size(ctx.ni);
+	ut_asserteq(NMBM_SIM_BLOCK_COUNT * (16 - NMBM_SIM_MAX_RATIO) / 16,
+		    size / NMBM_SIM_ERASESIZE);
+
+	ut_assertok(nmbm_test_write_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+	ut_asserteq(size, nmbm_get_avail_size(ctx.ni));
+	ut_assertok(nmbm_test_check_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	nmbm_test_teardown(&ctx);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_create, 0);
+
+/* Test reading unaligned ranges with and without the read_pages operation */
+static int nmbm_test_read_range(struct unit_test_state *uts)
+{
+	static const struct {
+		uint64_t addr;
+		size_t size;
+	} ranges[] = {
+		{ 0, 1 },
+		{ 1, NMBM_SIM_WRITESIZE },
+		{ NMBM_SIM_WRITESIZE - 1, NMBM_SIM_WRITESIZE + 2 },
+		{ NMBM_SIM_ERASESIZE - 100, NMBM_SIM_ERASESIZE },
+		{ 3 * NMBM_SIM_WRITESIZE, 5 * NMBM_SIM_ERASESIZE + 17 },
+		{ 0, NMBM_TEST_DATA_SIZE },
+	};
+	struct nmbm_test_ctx ctx;
+	uint32_t calls[2];
+	int i, j;
+
+	ut_assertok(nmbm_test_setup(uts, &ctx));
+	ut_assertok(nmbm_test_attach(uts, &ctx, NMBM_F_CREATE));
+	ut_assertok(nmbm_test_write_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	for (i = 0; i < 2; i++) {
+		ctx.sim->read_pages = i;
+		ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+		nmbm_sim_reset_stats(ctx.sim);
+
+		for (j = 0; j < ARRAY_SIZE(ranges); j++)
+			ut_assertok(nmbm_test_check_data(uts, &ctx,
+							 ranges[j].addr,
+							 ranges[j].size));
+
+		calls[i] = ctx.sim->stats.read_calls;
+	}
+
+	/* Whole pages of a block are read in one call */
+	ut_assert(calls[1] < calls[0] / 8);
+
+	nmbm_test_teardown(&ctx);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_read_range, 0);
+
+/* Test that factory bad blocks are skipped */
+static int nmbm_test_factory_bad(struct unit_test_state *uts)
+{
+	struct nmbm_test_ctx ctx;
+	uint32_t ba;
+
+	ut_assertok(nmbm_test_setup(uts, &ctx));
+
+	nmbm_sim_set_factory_bad(ctx.sim, 2);
+	nmbm_sim_set_factory_bad(ctx.sim, 3);
+	nmbm_sim_set_factory_bad(ctx.sim, NMBM_SIM_BLOCK_COUNT - 1);
+
+	ut_assertok(nmbm_test_attach(uts, &ctx, NMBM_F_CREATE));
+	ut_assertok(nmbm_test_write_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	for (ba = 0; ba < NMBM_TEST_DATA_BLOCKS; ba++)
+		ut_assertok(nmbm_check_bad_block(ctx.ni,
+						 ba * NMBM_SIM_ERASESIZE));
+
+	ut_asserteq(NMBM_BLOCK_BAD, nmbm_debug_get_phys_block_type(ctx.ni, 2));
+	ut_asserteq(NMBM_BLOCK_BAD, nmbm_debug_get_phys_block_type(ctx.ni, 3));
+
+	ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+	ut_assertok(nmbm_test_check_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	nmbm_test_teardown(&ctx);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_factory_bad, 0);
+
+/* Test that a block wearing out during use is remapped */
+static int nmbm_test_worn_block(struct unit_test_state *uts)
+{
+	struct nmbm_test_ctx ctx;
+
+	ut_assertok(nmbm_test_setup(uts, &ctx));
+	ut_assertok(nmbm_test_attach(uts, &ctx, NMBM_F_CREATE));
+
+	/* Erase failure */
+	nmbm_sim_set_worn(ctx.sim, 1);
+	ut_assertok(nmbm_test_write_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+	ut_assert(nmbm_sim_is_bad(ctx.sim, 1));
+	ut_assertok(nmbm_test_check_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	/*
+	 * Program failure on a block erased before. The error is reported to
+	 * the caller, and the block is remapped when it is erased again. It is
+	 * not marked bad, as the failure may have been caused by the data.
+	 */
+	ut_assertok(nmbm_erase_block_range(ctx.ni, 0, NMBM_TEST_DATA_SIZE,
+					   NULL));
+	nmbm_sim_set_worn(ctx.sim, 5);
+	ut_assert(nmbm_write_range(ctx.ni, 0, NMBM_TEST_DATA_SIZE, ctx.data,
+				   NMBM_MODE_PLACE_OOB, NULL) < 0);
+	ut_assertok(nmbm_test_write_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+	ut_asserteq(BLOCK_ST_NEED_REMAP, nmbm_debug_get_block_state(ctx.ni, 5));
+	ut_assertok(nmbm_test_check_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	/* The new mapping survives a reattach */
+	ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+	ut_asserteq(NMBM_BLOCK_BAD, nmbm_debug_get_phys_block_type(ctx.ni, 1));
+	ut_asserteq(BLOCK_ST_NEED_REMAP, nmbm_debug_get_block_state(ctx.ni, 5));
+	ut_assertok(nmbm_test_check_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	nmbm_test_teardown(&ctx);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_worn_block, 0);
+
+/* Test reading pages with correctable and uncorrectable bitflips */
+static int nmbm_test_bitflips(struct unit_test_state *uts)
+{
+	uint64_t addr = 3 * NMBM_SIM_ERASESIZE + 10 * NMBM_SIM_WRITESIZE;
+	struct nmbm_test_ctx ctx;
+	size_t retlen;
+	int i;
+
+	ut_assertok(nmbm_test_setup(uts, &ctx));
+	ut_assertok(nmbm_test_attach(uts, &ctx, NMBM_F_CREATE));
+	ut_assertok(nmbm_test_write_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	nmbm_sim_set_bitflips(ctx.sim, addr, ctx.sim->ecc_strength);
+	nmbm_sim_reset_stats(ctx.sim);
+	ut_assertok(nmbm_test_check_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+	ut_asserteq(ctx.sim->ecc_strength, ctx.sim->stats.bitflips);
+
+	nmbm_sim_set_bitflips(ctx.sim, addr, ctx.sim->ecc_strength + 1);
+
+	for (i = 0; i < 2; i++) {
+		ctx.sim->read_pages = i;
+		ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+
+		ut_assert(nmbm_read_range(ctx.ni, 100, NMBM_TEST_DATA_SIZE - 100,
+					  ctx.buf, NMBM_MODE_PLACE_OOB,
+					  &retlen) > 0);
+		ut_asserteq(addr - 100, retlen);
+		ut_asserteq(0, memcmp(ctx.data + 100, ctx.buf, retlen));
+	}
+
+	nmbm_test_teardown(&ctx);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_bitflips, 0);
+
+/* Test that the info tables are found again when the hints are missing */
+static int nmbm_test_no_hint(struct unit_test_state *uts)
+{
+	struct nmbm_test_ctx ctx;
+	uint32_t ba, page;
+	u8 *raw;
+
+	ut_assertok(nmbm_test_setup(uts, &ctx));
+	ut_assertok(nmbm_test_attach(uts, &ctx, NMBM_F_CREATE));
+	ut_assertok(nmbm_test_write_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	/* Old layout: the signature is repeated in every page of its block */
+	ba = nmbm_test_find_block(ctx.ni, NMBM_BLOCK_SIGNATURE);
+	ut_assert(ba < NMBM_SIM_BLOCK_COUNT);
+
+	raw = ctx.sim->data + (size_t)ba * ctx.sim->pages_per_block *
+	      ctx.sim->rawpage_size;
+	for (page = 1; page < ctx.sim->pages_per_block; page++)
+		memcpy(raw + page * ctx.sim->rawpage_size, raw,
+		       ctx.sim->rawpage_size);
+
+	ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+	ut_assertok(nmbm_test_check_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	nmbm_test_teardown(&ctx);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_no_hint, 0);
+
+/* Test that a stale hint is not trusted */
+static int nmbm_test_stale_hint(struct unit_test_state *uts)
+{
+	struct nmbm_test_ctx ctx;
+	uint32_t ba;
+
+	ut_assertok(nmbm_test_setup(uts, &ctx));
+	ut_assertok(nmbm_test_attach(uts, &ctx, NMBM_F_CREATE));
+	ut_assertok(nmbm_test_write_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	/* Main info table lost behind the back of NMBM */
+	ba = nmbm_test_find_block(ctx.ni, NMBM_BLOCK_MAIN_INFO_TABLE);
+	ut_assert(ba < NMBM_SIM_BLOCK_COUNT);
+
+	nmbm_test_drop(&ctx);
+	memset(ctx.sim->data + (size_t)ba * ctx.sim->pages_per_block *
+	       ctx.sim->rawpage_size, 0xff,
+	       (size_t)ctx.sim->pages_per_block * ctx.sim->rawpage_size);
+
+	ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+	ut_assertok(nmbm_test_check_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+	ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+	ut_assertok(nmbm_test_check_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	nmbm_test_teardown(&ctx);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_stale_hint, 0);
+
+/* Test that no hint is written after a hint page failed to be programmed */
+static int nmbm_test_hint_write_fail(struct unit_test_state *uts)
+{
+	struct nmbm_test_ctx ctx;
+	uint32_t ba, page, i;
+	u8 *raw;
+
+	ut_assertok(nmbm_test_setup(uts, &ctx));
+	ut_assertok(nmbm_test_attach(uts, &ctx, NMBM_F_CREATE));
+
+	ba = nmbm_test_find_block(ctx.ni, NMBM_BLOCK_SIGNATURE);
+	ut_assert(ba < NMBM_SIM_BLOCK_COUNT);
+
+	page = ctx.ni->hint_page;
+	ut_assert(page < ctx.sim->pages_per_block);
+
+	nmbm_sim_set_write_fail(ctx.sim, (uint64_t)ba * NMBM_SIM_ERASESIZE +
+				(uint64_t)page * NMBM_SIM_WRITESIZE);
+
+	/* Remapping a worn block updates the info tables and their hint */
+	ctx.ni->hint_main_table_ba = 0;
+	nmbm_sim_set_worn(ctx.sim, 1);
+	ut_assertok(nmbm_test_write_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+	ut_asserteq(ctx.sim->pages_per_block, ctx.ni->hint_page);
+
+	/* Nothing is written to the failed page or the pages after it */
+	ctx.ni->hint_main_table_ba = 0;
+	nmbm_sim_set_worn(ctx.sim, 2);
+	ut_assertok(nmbm_test_write_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	raw = ctx.sim->data + (size_t)ba * ctx.sim->pages_per_block *
+	      ctx.sim->rawpage_size;
+	for (i = page * ctx.sim->rawpage_size;
+	     i < ctx.sim->pages_per_block * ctx.sim->rawpage_size; i++)
+		ut_asserteq(0xff, raw[i]);
+
+	ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+	ut_asserteq(page, ctx.ni->hint_page);
+	ut_assertok(nmbm_test_check_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	nmbm_test_teardown(&ctx);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_hint_write_fail, 0);
+
+/* Test that power loss while creating the management area is recovered */
+static int nmbm_test_power_cut_create(struct unit_test_state *uts)
+{
+	struct nmbm_test_ctx ctx;
+	uint32_t cut;
+
+	for (cut = 1; cut < NMBM_TEST_MAX_CUTS; cut++) {
+		ut_assertok(nmbm_test_setup(uts, &ctx));
+
+		nmbm_sim_set_power_cut(ctx.sim, cut);
+		ctx.ni = nmbm_sim_attach(ctx.sim, NMBM_SIM_MAX_RATIO,
+					 NMBM_F_CREATE);
+		if (!ctx.sim->power_lost) {
+			nmbm_test_teardown(&ctx);
+			break;
+		}
+
+		nmbm_test_drop(&ctx);
+		nmbm_sim_power_on(ctx.sim);
+
+		ut_assertok(nmbm_test_attach(uts, &ctx, NMBM_F_CREATE));
+		ut_assertok(nmbm_test_write_data(uts, &ctx, 0,
+						 NMBM_TEST_DATA_SIZE));
+		ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+		ut_assertok(nmbm_test_check_data(uts, &ctx, 0,
+						 NMBM_TEST_DATA_SIZE));
+
+		nmbm_test_teardown(&ctx);
+	}
+
+	ut_assert(cut > 1 && cut < NMBM_TEST_MAX_CUTS);
+	printf("%u power cut points checked\n", cut - 1);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_power_cut_create, 0);
+
+/* Test that the info tables are written once per erase operation */
+static int nmbm_test_update_coalesce(struct unit_test_state *uts)
+{
+	struct nmbm_test_ctx ctx;
+	uint32_t written;
+
+	ut_assertok(nmbm_test_setup(uts, &ctx));
+	ut_assertok(nmbm_test_attach(uts, &ctx, NMBM_F_CREATE));
+
+	nmbm_sim_set_worn(ctx.sim, 0);
+	nmbm_sim_reset_stats(ctx.sim);
+	ut_assertok(nmbm_erase_block_range(ctx.ni, 0, NMBM_SIM_ERASESIZE,
+					   NULL));
+	written = ctx.sim->stats.pages_written;
+	ut_assert(written > 0);
+
+	nmbm_sim_set_worn(ctx.sim, 2);
+	nmbm_sim_set_worn(ctx.sim, 3);
+	nmbm_sim_set_worn(ctx.sim, 5);
+	nmbm_sim_reset_stats(ctx.sim);
+	ut_assertok(nmbm_erase_block_range(ctx.ni, 0, NMBM_TEST_DATA_SIZE,
+					   NULL));
+	ut_asserteq(written, ctx.sim->stats.pages_written);
+
+	ut_assertok(nmbm_write_range(ctx.ni, 0, NMBM_TEST_DATA_SIZE, ctx.data,
+				     NMBM_MODE_PLACE_OOB, NULL));
+	ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+	ut_assertok(nmbm_test_check_data(uts, &ctx, 0, NMBM_TEST_DATA_SIZE));
+
+	nmbm_test_teardown(&ctx);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_update_coalesce, 0);
+
+/*
+ * Test that power loss while remapping worn blocks does not affect data of
+ * other blocks
+ */
+static int nmbm_test_power_cut_remap(struct unit_test_state *uts)
+{
+	uint64_t addr = NMBM_TEST_DATA_SIZE - 2 * NMBM_SIM_ERASESIZE;
+	struct nmbm_test_ctx ctx;
+	uint32_t cut;
+
+	for (cut = 1; cut < NMBM_TEST_MAX_CUTS; cut++) {
+		ut_assertok(nmbm_test_setup(uts, &ctx));
+		ut_assertok(nmbm_test_attach(uts, &ctx, NMBM_F_CREATE));
+		ut_assertok(nmbm_test_write_data(uts, &ctx, 0, addr));
+
+		nmbm_sim_set_worn(ctx.sim, NMBM_TEST_DATA_BLOCKS - 2);
+		nmbm_sim_set_worn(ctx.sim, NMBM_TEST_DATA_BLOCKS - 1);
+		nmbm_sim_set_power_cut(ctx.sim, cut);
+
+		if (!nmbm_erase_block_range(ctx.ni, addr,
+					    2 * NMBM_SIM_ERASESIZE, NULL))
+			nmbm_write_range(ctx.ni, addr, 2 * NMBM_SIM_ERASESIZE,
+					 ctx.data + addr, NMBM_MODE_PLACE_OOB,
+					 NULL);
+
+		if (!ctx.sim->power_lost) {
+			ut_assertok(nmbm_test_check_data(uts, &ctx, 0,
+							 NMBM_TEST_DATA_SIZE));
+			nmbm_test_teardown(&ctx);
+			break;
+		}
+
+		nmbm_test_drop(&ctx);
+		nmbm_sim_power_on(ctx.sim);
+
+		ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+		ut_assertok(nmbm_test_check_data(uts, &ctx, 0, addr));
+
+		/* The interrupted blocks can be written again */
+		ut_assertok(nmbm_test_write_data(uts, &ctx, addr,
+						 2 * NMBM_SIM_ERASESIZE));
+		ut_assertok(nmbm_test_attach(uts, &ctx, 0));
+		ut_assertok(nmbm_test_check_data(uts, &ctx, 0,
+						 NMBM_TEST_DATA_SIZE));
+
+		nmbm_test_teardown(&ctx);
+	}
+
+	ut_assert(cut > 1 && cut < NMBM_TEST_MAX_CUTS);
+	printf("%u power cut points checked\n", cut - 1);
+
+	return 0;
+}
+NMBM_TEST(nmbm_test_power_cut_remap, 0);
@@ -0,0 +1,422 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * In-memory NAND simulator used as NMBM lower device by the unit tests.
+ *
+ * The chip content lives in a single buffer of raw pages. Bad blocks, worn
+ * out blocks, bitflips and power cuts can be injected, and every operation
+ * is accounted in the statistics together with a modelled busy time, so the
+ * numbers do not depend on the host running the sandbox.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <linux/errno.h>
+
+#include "nmbm-sim.h"
+
+/* Typical SPI-NAND timing, including the SPI transfer at 40 MB/s */
+static const struct nmbm_sim_timing nmbm_sim_default_timing = {
+	.cmd_ns = 2000,
+	.read_ns = 25000,
+	.prog_ns = 300000,
+	.erase_ns = 2000000,
+	.xfer_ns = 25,
+};
+
+static uint8_t *nmbm_sim_page(struct nmbm_sim *sim, uint32_t page)
+{
+	return sim->data + (size_t)page * sim->rawpage_size;
+}
+
+static uint32_t nmbm_sim_addr2page(struct nmbm_sim *sim, uint64_t addr)
+{
+	return lldiv(addr, sim->writesize);
+}
+
+static uint32_t nmbm_sim_addr2ba(struct nmbm_sim *sim, uint64_t addr)
+{
+	return lldiv(addr, sim->erasesize);
+}
+
+/*
+ * nmbm_sim_power_op - Account a program/erase operation for power cut
+ *
+ * Return true if the power is lost during this operation
+ */
+static bool nmbm_sim_power_op(struct nmbm_sim *sim)
+{
+	if (!sim->power_cut_ops)
+		return false;
+
+	if (--sim->power_cut_ops)
+		return false;
+
+	sim->power_lost = true;
+
+	return true;
+}
+
+static void nmbm_sim_copy_oob(struct nmbm_sim *sim, uint8_t *dst,
+			      const uint8_t *src, enum nmbm_oob_mode mode,
+			      bool to_chip)
+{
+	uint32_t off = 0, len = sim->oobsize;
+
+	/* Free OOB bytes start after the bad block marker */
+	if (mode == NMBM_MODE_AUTO_OOB) {
+		off = 2;
+		len = sim->oobsize - 2;
+	}
+
+	if (to_chip) {
+		uint32_t i;
+
+		for (i = 0; i < len; i++)
+			dst[off + i] &= src[i];
+	} else {
+		memcpy(dst, src + off, len);
+	}
+}
+
+static int nmbm_sim_read_one(struct nmbm_sim *sim, uint32_t page, void *buf,
+			     void *oob, enum nmbm_oob_mode mode)
+{
+	uint8_t *raw = nmbm_sim_page(sim, page);
+	uint32_t flips = sim->page_bitflips[page];
+	uint8_t *p = buf;
+	uint32_t i;
+
+	sim->stats.pages_read++;
+	sim->stats.busy_ns += sim->timing.read_ns;
+
+	if (buf) {
+		memcpy(buf, raw, sim->writesize);
+		sim->stats.busy_ns += (uint64_t)sim->timing.xfer_ns *
+				      sim->writesize;
+	}
+
+	if (oob) {
+		nmbm_sim_copy_oob(sim, oob, raw + sim->writesize, mode, false);
+		sim->stats.busy_ns += (uint64_t)sim->timing.xfer_ns *
+				      sim->oobsize;
+	}
+
+	if (!flips || mode == NMBM_MODE_RAW)
+		return 0;
+
+	if (flips <= sim->ecc_strength) {
+		sim->stats.bitflips += flips;
+		return 0;
+	}
+
+	/* Uncorrectable, return the data as read from the cells */
+	if (p) {
+		for (i = 0; i < min_t(uint32_t, flips, sim->writesize); i++)
+			p[i * 7 % sim->writesize] ^= BIT(i % 8);
+	}
+
+	sim->stats.ecc_failures++;
+
+	return 1;
+}
+
+static int nmbm_sim_read_page(void *arg, uint64_t addr, void *buf, void *oob,
+			      enum nmbm_oob_mode mode)
+{
+	struct nmbm_sim *sim = arg;
+
+	if (sim->power_lost)
+		return -EIO;
+
+	sim->stats.read_calls++;
+	sim->stats.busy_ns += sim->timing.cmd_ns;
+
+	return nmbm_sim_read_one(sim, nmbm_sim_addr2page(sim, addr), buf, oob,
+				 mode);
+}
+
+static int nmbm_sim_read_pages(void *arg, uint64_t addr, void *buf,
+			       size_t size, enum nmbm_oob_mode mode)
+{
+	struct nmbm_sim *sim = arg;
+	uint32_t page = nmbm_sim_addr2page(sim, addr);
+	uint32_t i, count = size / sim->writesize;
+	int ret, ecc_failed = 0;
+
+	if (sim->power_lost)
+		return -EIO;
+
+	if (nmbm_sim_addr2ba(sim, addr) !=
+	    nmbm_sim_addr2ba(sim, addr + size - 1))
+		return -EINVAL;
+
+	sim->stats.read_calls++;
+	sim->stats.busy_ns += sim->timing.cmd_ns;
+
+	for (i = 0; i < count; i++) {
+		ret = nmbm_sim_read_one(sim, page + i,
+					buf + i * sim->writesize, NULL, mode);
+		if (ret)
+			ecc_failed = ret;
+	}
+
+	return ecc_failed;
+}
+
+static int nmbm_sim_write_page(void *arg, uint64_t addr, const void *buf,
+			       const void *oob, enum nmbm_oob_mode mode)
+{
+	struct nmbm_sim *sim = arg;
+	uint32_t page = nmbm_sim_addr2page(sim, addr);
+	uint8_t *raw = nmbm_sim_page(sim, page);
+	const uint8_t *src = buf;
+	uint32_t i, len = sim->writesize;
+
+	if (sim->power_lost)
+		return -EIO;
+
+	sim->stats.busy_ns += sim->timing.cmd_ns;
+
+	if (sim->block_flags[page / sim->pages_per_block] & NMBM_SIM_BLK_WORN)
+		return -EIO;
+
+	if (sim->write_fail && page == sim->write_fail_page)
+		return -EIO;
+
+	sim->stats.pages_written++;
+	sim->stats.busy_ns += sim->timing.prog_ns +
+			      (uint64_t)sim->timing.xfer_ns * sim->rawpage_size;
+
+	/* Only the first half of the page is programmed before power loss */
+	if (nmbm_sim_power_op(sim)) {
+		len /= 2;
+		oob = NULL;
+		sim->page_bitflips[page] = NMBM_SIM_PAGE_UNSTABLE;
+	}
+
+	/* Programming can only clear bits */
+	if (src) {
+		for (i = 0; i < len; i++)
+			raw[i] &= src[i];
+	}
+
+	if (oob)
+		nmbm_sim_copy_oob(sim, raw + sim->writesize, oob, mode, true);
+
+	return sim->power_lost ? -EIO : 0;
+}
+
+static int nmbm_sim_erase_block(void *arg, uint64_t addr)
+{
+	struct nmbm_sim *sim = arg;
+	uint32_t ba = nmbm_sim_addr2ba(sim, addr);
+	uint32_t page = ba * sim->pages_per_block;
+	uint32_t i, count = sim->pages_per_block;
+
+	if (sim->power_lost)
+		return -EIO;
+
+	sim->stats.busy_ns += sim->timing.cmd_ns;
+
+	if (sim->block_flags[ba] & NMBM_SIM_BLK_WORN)
+		return -EIO;
+
+	sim->stats.blocks_erased++;
+	sim->stats.busy_ns += sim->timing.erase_ns;
+
+	/* Only the first half of the block is erased before power loss */
+	if (nmbm_sim_power_op(sim)) {
+		count /= 2;
+
+		for (i = count; i < sim->pages_per_block; i++)
+			sim->page_bitflips[page + i] = NMBM_SIM_PAGE_UNSTABLE;
+	}
+
+	memset(nmbm_sim_page(sim, page), 0xff,
+	       (size_t)count * sim->rawpage_size);
+	memset(sim->page_bitflips + page, 0, count);
+
+	return sim->power_lost ? -EIO : 0;
+}
+
+static int nmbm_sim_is_bad_block(void *arg, uint64_t addr)
+{
+	struct nmbm_sim *sim = arg;
+
+	return nmbm_sim_is_bad(sim, nmbm_sim_addr2ba(sim, addr));
+}
+
+static int nmbm_sim_mark_bad_block(void *arg, uint64_t addr)
+{
+	struct nmbm_sim *sim = arg;
+	uint32_t ba = nmbm_sim_addr2ba(sim, addr);
+
+	if (sim->power_lost)
+		return -EIO;
+
+	sim->block_flags[ba] |= NMBM_SIM_BLK_BAD;
+	sim->stats.blocks_marked_bad++;
+
+	return 0;
+}
+
+static void nmbm_sim_logprint(void *arg, enum nmbm_log_category level,
+			      const char *fmt, va_list ap)
+{
+	struct nmbm_sim *sim = arg;
+
+	if (level >= sim->log_level)
+		vprintf(fmt, ap);
+}
+
+bool nmbm_sim_is_bad(struct nmbm_sim *sim, uint32_t ba)
+{
+	return sim->block_flags[ba] & NMBM_SIM_BLK_BAD;
+}
+
+void nmbm_sim_set_factory_bad(struct nmbm_sim *sim, uint32_t ba)
+{
+	sim->block_flags[ba] |= NMBM_SIM_BLK_BAD | NMBM_SIM_BLK_WORN;
+}
+
+void nmbm_sim_set_worn(struct nmbm_sim *sim, uint32_t ba)
+{
+	sim->block_flags[ba] |= NMBM_SIM_BLK_WORN;
+}
+
+void nmbm_sim_set_bitflips(struct nmbm_sim *sim, uint64_t addr, uint32_t count)
+{
+	sim->page_bitflips[nmbm_sim_addr2page(sim, addr)] = count;
+}
+
+void nmbm_sim_set_write_fail(struct nmbm_sim *sim, uint64_t addr)
+{
+	sim->write_fail_page = nmbm_sim_addr2page(sim, addr);
+	sim->write_fail = true;
+}
+
+void nmbm_sim_set_power_cut(struct nmbm_sim *sim, uint32_t ops)
+{
+	sim->power_cut_ops = ops;
+}
+
+void nmbm_sim_power_on(struct nmbm_sim *sim)
+{
+	sim->power_cut_ops = 0;
+	sim->power_lost = false;
+}
+
+void nmbm_sim_reset_stats(struct nmbm_sim *sim)
+{
+	memset(&sim->stats, 0, sizeof(sim->stats));
+}
+
+void nmbm_sim_fill_pattern(void *buf, size_t size, uint32_t seed)
+{
+	uint32_t x = seed | 1;
+	uint8_t *p = buf;
+	size_t i;
+
+	for (i = 0; i < size; i++) {
+		/* xorshift32 */
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		p[i] = x;
+	}
+}
+
+void nmbm_sim_init_lower(struct nmbm_sim *sim, struct nmbm_lower_device *nld,
+			 uint32_t max_ratio, int flags)
+{
+	memset(nld, 0, sizeof(*nld));
+
+	nld->max_ratio = max_ratio;
+	nld->flags = flags;
+
+	nld->size = (uint64_t)sim->block_count * sim->erasesize;
+	nld->erasesize = sim->erasesize;
+	nld->writesize = sim->writesize;
+	nld->oobsize = sim->oobsize;
+	nld->oobavail = sim->oobsize - 2;
+
+	nld->arg = sim;
+	nld->read_page = nmbm_sim_read_page;
+	if (sim->read_pages)
+		nld->read_pages = nmbm_sim_read_pages;
+	nld->write_page = nmbm_sim_write_page;
+	nld->erase_block = nmbm_sim_erase_block;
+	nld->is_bad_block = nmbm_sim_is_bad_block;
+	nld->mark_bad_block = nmbm_sim_mark_bad_block;
+	nld->logprint = nmbm_sim_logprint;
+}
+
+struct nmbm_instance *nmbm_sim_attach(struct nmbm_sim *sim, uint32_t max_ratio,
+				      int flags)
+{
+	struct nmbm_lower_device nld;
+	struct nmbm_instance *ni;
+	int ret;
+
+	nmbm_sim_init_lower(sim, &nld, max_ratio, flags);
+
+	ni = calloc(1, nmbm_calc_structure_size(&nld));
+	if (!ni)
+		return NULL;
+
+	ret = nmbm_attach(&nld, ni);
+	if (ret) {
+		free(ni);
+		return NULL;
+	}
+
+	return ni;
+}
+
+struct nmbm_sim *nmbm_sim_create(uint32_t block_count, uint32_t erasesize,
+				 uint32_t writesize, uint32_t oobsize)
+{
+	struct nmbm_sim *sim;
+	uint32_t page_count;
+
+	sim = calloc(1, sizeof(*sim));
+	if (!sim)
+		return NULL;
+
+	sim->block_count = block_count;
+	sim->erasesize = erasesize;
+	sim->writesize = writesize;
+	sim->oobsize = oobsize;
+	sim->pages_per_block = erasesize / writesize;
+	sim->rawpage_size = writesize + oobsize;
+	sim->ecc_strength = 4;
+	sim->read_pages = true;
+	sim->log_level = __NMBM_LOG_MAX;
+	sim->timing = nmbm_sim_default_timing;
+
+	page_count = block_count * sim->pages_per_block;
+
+	sim->data = malloc((size_t)page_count * sim->rawpage_size);
+	sim->block_flags = calloc(1, block_count);
+	sim->page_bitflips = calloc(1, page_count);
+
+	if (!sim->data || !sim->block_flags || !sim->page_bitflips) {
+		nmbm_sim_destroy(sim);
+		return NULL;
+	}
+
+	memset(sim->data, 0xff, (size_t)page_count * sim->rawpage_size);
+
+	return sim;
+}
+
+void nmbm_sim_destroy(struct nmbm_sim *sim)
+{
+	if (!sim)
+		return;
+
+	free(sim->data);
+	free(sim->block_flags);
+	free(sim->page_bitflips);
+	free(sim);
+}
@@ -0,0 +1,125 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * In-memory NAND simulator used as NMBM lower device by the unit tests
+ */
+
+#ifndef __NMBM_SIM_H__
+#define __NMBM_SIM_H__
+
+#include <nmbm/nmbm.h>
+
+/* Geometry of the chip used by the tests: 16 MiB SPI-NAND */
+#define NMBM_SIM_BLOCK_COUNT		128
+#define NMBM_SIM_ERASESIZE		0x20000
+#define NMBM_SIM_WRITESIZE		0x800
+#define NMBM_SIM_OOBSIZE		64
+#define NMBM_SIM_MAX_RATIO		2
+
+/* Block flags */
+#define NMBM_SIM_BLK_BAD		BIT(0)	/* Bad block marker present */
+#define NMBM_SIM_BLK_WORN		BIT(1)	/* Erase/program will fail */
+
+/* Bitflip count of a page left half-programmed/half-erased by a power cut */
+#define NMBM_SIM_PAGE_UNSTABLE		0xff
+
+/*
+ * struct nmbm_sim_timing - Chip timing used to model the busy time
+ *
+ * @cmd_ns:	Command/address cycles and driver overhead of one lower call
+ * @read_ns:	Page read time (tR)
+ * @prog_ns:	Page program time (tPROG)
+ * @erase_ns:	Block erase time (tBERS)
+ * @xfer_ns:	Bus transfer time of one byte
+ */
+struct nmbm_sim_timing {
+	uint32_t cmd_ns;
+	uint32_t read_ns;
+	uint32_t prog_ns;
+	uint32_t erase_ns;
+	uint32_t xfer_ns;
+};
+
+/*
+ * struct nmbm_sim_stats - Operation counters of the simulator
+ *
+ * @read_calls:		Calls of read_page and read_pages
+ * @pages_read:		Pages transferred from the chip
+ * @pages_written:	Pages programmed
+ * @blocks_erased:	Blocks erased
+ * @blocks_marked_bad:	Blocks marked bad by the upper layer
+ * @bitflips:		Bitflips corrected by ECC
+ * @ecc_failures:	Uncorrectable page reads
+ * @busy_ns:		Modelled chip busy time
+ */
+struct nmbm_sim_stats {
+	uint32_t read_calls;
+	uint32_t pages_read;
+	uint32_t pages_written;
+	uint32_t blocks_erased;
+	uint32_t blocks_marked_bad;
+	uint32_t bitflips;
+	uint32_t ecc_failures;
+	uint64_t busy_ns;
+};
+
+struct nmbm_sim {
+	uint32_t block_count;
+	uint32_t erasesize;
+	uint32_t writesize;
+	uint32_t oobsize;
+	uint32_t pages_per_block;
+	uint32_t rawpage_size;
+
+	/* Maximum number of bitflips per page ECC can correct */
+	uint32_t ecc_strength;
+
+	/* Provide the read_pages operation to NMBM */
+	bool read_pages;
+
+	/* NMBM log messages below this level are dropped */
+	enum nmbm_log_category log_level;
+
+	uint8_t *data;		/* Raw pages: main data followed by OOB */
+	uint8_t *block_flags;
+	uint8_t *page_bitflips;
+
+	/* Page whose programs fail, leaving it erased */
+	uint32_t write_fail_page;
+	bool write_fail;
+
+	/* Program/erase operations left before power is lost, 0 for never */
+	uint32_t power_cut_ops;
+	bool power_lost;
+
+	struct nmbm_sim_timing timing;
+	struct nmbm_sim_stats stats;
+};
+
+struct nmbm_sim *nmbm_sim_create(uint32_t block_count, uint32_t erasesize,
+				 uint32_t writesize, uint32_t oobsize);
+void nmbm_sim_destroy(struct nmbm_sim *sim);
+
+/* Fill a lower device structure with the simulator operations */
+void nmbm_sim_init_lower(struct nmbm_sim *sim, struct nmbm_lower_device *nld,
+			 uint32_t max_ratio, int flags);
+
+/* Attach a new NMBM instance to the simulator, NULL on failure */
+struct nmbm_instance *nmbm_sim_attach(struct nmbm_sim *sim, uint32_t max_ratio,
+				      int flags);
+
+void nmbm_sim_set_factory_bad(struct nmbm_sim *sim, uint32_t ba);
+void nmbm_sim_set_worn(struct nmbm_sim *sim, uint32_t ba);
+void nmbm_sim_set_bitflips(struct nmbm_sim *sim, uint64_t addr, uint32_t count);
+void nmbm_sim_set_write_fail(struct nmbm_sim *sim, uint64_t addr);
+bool nmbm_sim_is_bad(struct nmbm_sim *sim, uint32_t ba);
+
+/* Lose power on the @ops-th program/erase operation from now */
+void nmbm_sim_set_power_cut(struct nmbm_sim *sim, uint32_t ops);
+void nmbm_sim_power_on(struct nmbm_sim *sim);
+
+void nmbm_sim_reset_stats(struct nmbm_sim *sim);
+
+/* Fill a buffer with a reproducible pseudo random pattern */
+void nmbm_sim_fill_pattern(void *buf, size_t size, uint32_t seed);
+
+#endif /* __NMBM_SIM_H__ */
@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Tests of memcpy, memmove and memset with all the alignments of the source
+ * and destination, and benchmarks of their throughput. The tests can be run
+ * on the target to check the architecture optimized versions.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <test/bench.h>
+#include <test/suites.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define STRING_TEST(_name, _flags)	UNIT_TEST(_name, _flags, string_test)
+
+/* Lengths are tested up to 2 blocks of the optimized loops, plus bytes */
+#define STRING_TEST_MAX_LEN	80
+#define STRING_TEST_ALIGN	8
+#define STRING_TEST_GUARD	16
+#define STRING_TEST_BUF_SIZE	(STRING_TEST_MAX_LEN + STRING_TEST_ALIGN + \
+				 2 * STRING_TEST_GUARD)
+
+/* Reference copy, not using the functions under test */
+static void string_test_copy(u8 *dst, const u8 *src, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		dst[i] = src[i];
+}
+
+static int string_test_memcpy(struct unit_test_state *uts)
+{
+	u8 src[STRING_TEST_BUF_SIZE], dst[STRING_TEST_BUF_SIZE];
+	u8 ref[STRING_TEST_BUF_SIZE];
+	int sa, da, len;
+	u8 *s, *d;
+
+	ut_fill_pattern(src, sizeof(src), 1);
+
+	for (sa = 0; sa < STRING_TEST_ALIGN; sa++) {
+		for (da = 0; da < STRING_TEST_ALIGN; da++) {
+			for (len = 0; len <= STRING_TEST_MAX_LEN; len++) {
+				s = src + STRING_TEST_GUARD + sa;
+				d = dst + STRING_TEST_GUARD + da;
+
+				ut_fill_pattern(dst, sizeof(dst), 0x80);
+				ut_fill_pattern(ref, sizeof(ref), 0x80);
+				string_test_copy(ref + (d - dst), s, len);
+
+				ut_asserteq_ptr(d, memcpy(d, s, len));
+				ut_asserteq(0, memcmp(ref, dst, sizeof(dst)));
+			}
+		}
+	}
+
+	return 0;
+}
+STRING_TEST(string_test_memcpy, 0);
+
+static int string_test_memmove(struct unit_test_state *uts)
+{
+	u8 buf[STRING_TEST_BUF_SIZE + 2 * STRING_TEST_ALIGN];
+	u8 ref[sizeof(buf)];
+	int sa, shift, len;
+	u8 *s, *d;
+
+	/* Overlapping moves in both directions, by up to 2 words */
+	for (sa = 0; sa < STRING_TEST_ALIGN; sa++) {
+		for (shift = -STRING_TEST_ALIGN; shift <= STRING_TEST_ALIGN;
+		     shift++) {
+			for (len = 0; len <= STRING_TEST_MAX_LEN; len++) {
+				s = buf + STRING_TEST_GUARD + STRING_TEST_ALIGN +
+				    sa;
+				d = s + shift;
+
+				ut_fill_pattern(buf, sizeof(buf), sa + len);
+				ut_fill_pattern(ref, sizeof(ref), sa + len);
+				string_test_copy(ref + (d - buf), s, len);
+
+				ut_asserteq_ptr(d, memmove(d, s, len));
+				ut_asserteq(0, memcmp(ref, buf, sizeof(buf)));
+			}
+		}
+	}
+
+	return 0;
+}
+STRING_TEST(string_test_memmove, 0);
+
+static int string_test_memset(struct unit_test_state *uts)
+{
+	static const int values[] = { 0, 0x5a, 0xff, 0x1a5 };
+	u8 buf[STRING_TEST_BUF_SIZE], ref[STRING_TEST_BUF_SIZE];
+	int da, len, i, j;
+	u8 *d;
+
+	for (i = 0; i < ARRAY_SIZE(values); i++) {
+		for (da = 0; da < STRING_TEST_ALIGN; da++) {
+			for (len = 0; len <= STRING_TEST_MAX_LEN; len++) {
+				d = buf + STRING_TEST_GUARD + da;
+
+				ut_fill_pattern(buf, sizeof(buf), len);
+				ut_fill_pattern(ref, sizeof(ref), len);
+				for (j = 0; j < len; j++)
+					ref[d - buf + j] = values[i];
+
+				ut_asserteq_ptr(d, memset(d, values[i], len));
+				ut_asserteq(0, memcmp(ref, buf, sizeof(buf)));
+			}
+		}
+	}
+
+	return 0;
+}
+STRING_TEST(string_test_memset, 0);
+
+/* Throughput of the copy functions */
+static int string_test_bench(struct unit_test_state *uts)
+{
+	ulong start;
+	u8 *src, *dst;
+	int i;
+
+	src = malloc(UT_BENCH_SIZE + STRING_TEST_ALIGN);
+	ut_assertnonnull(src);
+	dst = malloc(UT_BENCH_SIZE + STRING_TEST_ALIGN);
+	ut_assertnonnull(dst);
+
+	ut_fill_pattern(src, UT_BENCH_SIZE + STRING_TEST_ALIGN, 3);
+
+	start = timer_get_us();
+	for (i = 0; i < UT_BENCH_LOOPS; i++)
+		memcpy(dst, src, UT_BENCH_SIZE);
+	ut_bench_report("memcpy", start);
+
+	start = timer_get_us();
+	for (i = 0; i < UT_BENCH_LOOPS; i++)
+		memcpy(dst, src + 1, UT_BENCH_SIZE);
+	ut_bench_report("memcpy (unaligned)", start);
+
+	start = timer_get_us();
+	for (i = 0; i < UT_BENCH_LOOPS; i++)
+		memmove(dst + 4, dst, UT_BENCH_SIZE);
+	ut_bench_report("memmove (backward)", start);
+
+	start = timer_get_us();
+	for (i = 0; i < UT_BENCH_LOOPS; i++)
+		memset(dst, i, UT_BENCH_SIZE);
+	ut_bench_report("memset", start);
+
+	free(dst);
+	free(src);
+
+	return 0;
+}
+STRING_TEST(string_test_bench, 0);
+
+int do_ut_string(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	struct unit_test *tests = ll_entry_start(struct unit_test, string_test);
+	const int n_ents = ll_entry_count(struct unit_test, string_test);
+
+	return cmd_ut_category("string", tests, n_ents, argc, argv);
+}